@@ -0,0 +1,31 @@
+// Заменитель Arduino.h для сборки прошивки на ПК (env:native и CMake).
+// Время виртуальное: его двигает стенд через arduino_shim.h, а не часы ПК.
+// HardwareSerial нет и на плате: USART ведёт src/usart_rx.cpp, его железную
+// часть здесь заменяет arduino_shim.cpp.
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#define F_CPU 16000000UL
+#define LED_BUILTIN 13
+#define INPUT 0
+#define OUTPUT 1
+#define LOW 0
+#define HIGH 1
+
+unsigned long millis();
+unsigned long micros();
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+void analogWrite(uint8_t pin, int value);
+
+// Флеш и ОЗУ на ПК — одна память
+#define PROGMEM
+#define pgm_read_byte(address) (*(const uint8_t *)(address))
+
+// В ядре AVR min и max — макросы; шаблоны не ломают заголовки STL стенда
+template <typename T>
+inline T min(T a, T b) { return a < b ? a : b; }
+template <typename T>
+inline T max(T a, T b) { return a > b ? a : b; }
+
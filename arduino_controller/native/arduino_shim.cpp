@@ -0,0 +1,107 @@
+#include "Arduino.h"
+#include "arduino_shim.h"
+#include "fade_engine.h"
+#include "usart_rx.h"
+
+#define SHIM_PIN_COUNT 20
+#define SHIM_TX_BUFFER_SIZE 256
+
+static uint64_t nowUs = 0;
+static unsigned long serialBaud = 0;
+
+static bool timerRunning = false;
+static uint64_t nextTickUs = 0;
+
+static uint8_t txBuffer[SHIM_TX_BUFFER_SIZE];
+static size_t txCount = 0;
+
+static int pwm[SHIM_PIN_COUNT];
+static ShimPwmHook pwmHook = 0;
+
+void shimReset()
+{
+    nowUs = 0;
+    serialBaud = 0;
+    timerRunning = false;
+    txCount = 0;
+    for (int &value : pwm)
+        value = 0;
+    pwmHook = 0;
+}
+
+// Тики таймера приходят в своё время, даже если шаг длиннее периода
+void shimAdvance(uint64_t us)
+{
+    const uint64_t target = nowUs + us;
+    while (timerRunning && nextTickUs <= target)
+    {
+        nowUs = nextTickUs;
+        nextTickUs += FADE_TICK_US;
+        fadeTick();
+    }
+    nowUs = target;
+}
+
+uint64_t shimNow() { return nowUs; }
+
+// Счётчики ядра AVR 32-битные и переполняются так же
+unsigned long millis() { return (uint32_t)(nowUs / 1000); }
+unsigned long micros() { return (uint32_t)nowUs; }
+
+// Железная часть src/fade_engine.h: первый тик через период от запуска
+void fadeTimerStart()
+{
+    timerRunning = true;
+    nextTickUs = nowUs + FADE_TICK_US;
+}
+
+void pinMode(uint8_t, uint8_t) {}
+void digitalWrite(uint8_t, uint8_t) {}
+
+void analogWrite(uint8_t pin, int value)
+{
+    if (pin < SHIM_PIN_COUNT)
+        pwm[pin] = value;
+    if (pwmHook)
+        pwmHook(pin, value);
+}
+
+void shimSetPwmHook(ShimPwmHook hook) { pwmHook = hook; }
+int shimPwm(uint8_t pin) { return pin < SHIM_PIN_COUNT ? pwm[pin] : 0; }
+
+bool shimSerialReceive(uint8_t byte)
+{
+    if (serialBaud == 0)
+        return false;
+    usartReceive(byte);
+    return true;
+}
+
+unsigned long shimSerialBaud() { return serialBaud; }
+
+size_t shimSerialTake(uint8_t *out, size_t size)
+{
+    const size_t n = txCount < size ? txCount : size;
+    for (size_t i = 0; i < n; i++)
+        out[i] = txBuffer[i];
+    for (size_t i = n; i < txCount; i++)
+        txBuffer[i - n] = txBuffer[i];
+    txCount -= n;
+    return n;
+}
+
+// Железная часть src/usart_rx.h: смена скорости сбрасывает приёмник, передача
+// копится, пока стенд её не заберёт
+void usartBegin(uint32_t baud)
+{
+    serialBaud = baud;
+    usartReset();
+}
+
+void usartWrite(const uint8_t *data, uint8_t size)
+{
+    for (uint8_t i = 0; i < size && txCount < SHIM_TX_BUFFER_SIZE; i++)
+        txBuffer[txCount++] = data[i];
+}
+
+void usartFlush() {}
@@ -0,0 +1,28 @@
+// Управление заменителем Arduino со стороны стенда: виртуальные часы,
+// байты на входе USART, перехват ШИМ
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// Точки входа прошивки из src/main.cpp
+void setup();
+void loop();
+
+void shimReset();
+
+// Виртуальное время в микросекундах; millis() и micros() прошивки идут от него
+// и переполняются, как на плате. Тики таймера затухания идут по нему же
+void shimAdvance(uint64_t us);
+uint64_t shimNow();
+
+// Байт пришёл в USART: прерывание приёма прошивки вызывается сразу.
+// false — приёмник выключен и байт потерян
+bool shimSerialReceive(uint8_t byte);
+unsigned long shimSerialBaud();
+// Забирает то, что прошивка отправила в порт; возвращает число байтов
+size_t shimSerialTake(uint8_t *out, size_t size);
+
+// Вызывается на каждый analogWrite прошивки
+typedef void (*ShimPwmHook)(uint8_t pin, int value);
+void shimSetPwmHook(ShimPwmHook hook);
+int shimPwm(uint8_t pin);
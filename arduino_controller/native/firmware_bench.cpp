@@ -0,0 +1,364 @@
+// Стенд прошивки на ПК: кадры протокола v2 идут через заменитель USART в
+// setup()/loop() из src/main.cpp, время виртуальное.
+// firmware_native [--frames N] [--encoding raw|nibble|delta|delta-nibble] [--baud B]
+//                 [--fps F] [--loop-us U] [--noise N] [--start-ms M]
+//   --baud 0 (по умолчанию) — линия без ограничения: перед каждым loop() байты идут,
+//   пока прерывание приёма не соберёт целый кадр, меряется предельная скорость разбора.
+//   --baud B — байты приходят в темпе 8N1 на скорости B, --fps задаёт частоту кадров
+//   (0 — кадры идут вплотную). Кадр, собранный прерыванием, пока loop() не забрал
+//   предыдущий, теряется как на плате.
+//   --loop-us — сколько виртуального времени занимает один проход loop().
+//   --noise N — в среднем каждый N-й байт на линии с одним испорченным битом.
+//   --start-ms M — виртуальные часы стартуют с M мс: 4294960000 проверяет
+//   переполнение millis() на 49-е сутки.
+// firmware_native --check-curves — сверяет таблицы кривых яркости с формулами
+//   и то, что прошивка после SET_CURVE пишет в ШИМ; код выхода 1 при расхождении.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "arduino_shim.h"
+#include "brightness_curves.h"
+#include "fade_engine.h"
+#include "shared_protocol.h"
+#include "usart_rx.h"
+
+#define BENCH_DEFAULT_FRAMES 1000000
+#define BENCH_DEFAULT_LOOP_US 1
+#define BENCH_CHANNELS 6
+
+// Яркости внутри прошивки
+extern ProtocolLevels received;
+
+// Выводы каналов — как pinMap в src/main.cpp
+static const uint8_t channelPins[BENCH_CHANNELS] = {3, 5, 6, 9, 10, 11};
+
+// Кадр от конца передачи до analogWrite: ждём, пока яркость канала
+// не станет той, что пришла в кадре. Яркость берём у fade_engine: на выводе
+// она уже пересчитана по кривой
+static bool pending[BENCH_CHANNELS];
+static int pendingLevel[BENCH_CHANNELS];
+static uint64_t pendingSince[BENCH_CHANNELS];
+static std::vector<unsigned long> latencies;
+
+// Шаги затухания: время от подъёма яркости или предыдущего шага
+static int lastLevel[BENCH_CHANNELS];
+static uint64_t lastLevelChange[BENCH_CHANNELS];
+static unsigned long long fadeSteps = 0;
+static uint64_t fadeSum = 0, fadeMin = UINT64_MAX, fadeMax = 0;
+
+static void onPwm(uint8_t pin, int)
+{
+    for (int c = 0; c < BENCH_CHANNELS; c++)
+    {
+        if (channelPins[c] != pin)
+            continue;
+        const int level = fadeLevel((uint8_t)c);
+        if (level < lastLevel[c])
+        {
+            const uint64_t interval = shimNow() - lastLevelChange[c];
+            fadeSteps++;
+            fadeSum += interval;
+            fadeMin = std::min(fadeMin, interval);
+            fadeMax = std::max(fadeMax, interval);
+        }
+        lastLevel[c] = level;
+        lastLevelChange[c] = shimNow();
+
+        if (!pending[c] || level != pendingLevel[c])
+            continue;
+        latencies.push_back((unsigned long)(shimNow() - pendingSince[c]));
+        pending[c] = false;
+    }
+}
+
+// Похоже на огибающие полос: спад с редкими всплесками
+static void nextLevels(uint8_t *levels)
+{
+    for (int c = 0; c < BENCH_CHANNELS; c++)
+    {
+        if (rand() % 10 == 0)
+            levels[c] = (uint8_t)(rand() % 256);
+        else
+            levels[c] = (uint8_t)std::max(0, levels[c] - rand() % 24);
+    }
+}
+
+// Счётчики прошивки 16-битные: накапливаем приращения, пока они не обернулись
+static void accumulate(uint16_t counter, uint16_t *last, unsigned long long *total)
+{
+    *total += (uint16_t)(counter - *last);
+    *last = counter;
+}
+
+// Формулы, по которым посчитаны таблицы src/brightness_curves.cpp
+static double curveReference(uint8_t curve, int level)
+{
+    const double x = level / 255.0;
+    if (curve == PROTOCOL_CURVE_GAMMA)
+        return 255.0 * pow(x, 2.2);
+    if (curve == PROTOCOL_CURVE_CIE)
+    {
+        const double lightness = 100.0 * x;
+        return 255.0 * (lightness <= 8.0 ? lightness / 903.3 : pow((lightness + 16.0) / 116.0, 3.0));
+    }
+    return 255.0 * x;
+}
+
+static void feedFrame(const uint8_t *wire, uint8_t size)
+{
+    for (uint8_t i = 0; i < size; i++)
+        shimSerialReceive(wire[i]);
+    loop();
+}
+
+static int checkCurves()
+{
+    int errors = 0;
+    ProtocolEncoder encoder;
+    protocolEncoderInit(&encoder, 0, 0);
+    uint8_t wire[PROTOCOL_MAX_FRAME];
+    uint8_t levels[BENCH_CHANNELS];
+
+    for (uint8_t curve = 0; curve < PROTOCOL_CURVE_COUNT; curve++)
+    {
+        const uint8_t *table = brightnessTable(curve);
+        for (int level = 0; level < 256; level++)
+        {
+            const int expected = (int)floor(curveReference(curve, level) + 0.5);
+            const int actual = pgm_read_byte(table + level);
+            if (actual != expected || (level > 0 && actual < pgm_read_byte(table + level - 1)))
+            {
+                printf("curve %d, level %d: table %d, expected %d\n", curve, level, actual, expected);
+                errors++;
+            }
+        }
+
+        // Кривая через управляющий кадр; ответ — кривые всех каналов
+        feedFrame(wire, protocolEncodeControl(PROTOCOL_CMD_SET_CURVE, &curve, 1, wire));
+        uint8_t reply[PROTOCOL_MAX_FRAME];
+        const size_t replySize = shimSerialTake(reply, sizeof(reply));
+        ProtocolDecoder decoder;
+        protocolDecoderInit(&decoder);
+        bool acknowledged = false;
+        for (size_t i = 0; i < replySize; i++)
+        {
+            if (!protocolDecode(&decoder, reply[i]) || protocolControlCommand(&decoder) != PROTOCOL_CMD_SET_CURVE)
+                continue;
+            acknowledged = protocolControlArgsSize(&decoder) == BENCH_CHANNELS;
+            for (uint8_t c = 0; acknowledged && c < BENCH_CHANNELS; c++)
+                acknowledged = protocolControlArgs(&decoder)[c] == curve;
+        }
+        if (!acknowledged)
+        {
+            printf("curve %d: SET_CURVE not acknowledged\n", curve);
+            errors++;
+        }
+
+        // Все каналы гаснут, затем яркость растёт по шагу: каждый шаг пишется в ШИМ
+        shimAdvance(1000000);
+        for (int level = 0; level < 256; level++)
+        {
+            memset(levels, level, sizeof(levels));
+            feedFrame(wire, protocolEncodeLevels(&encoder, levels, BENCH_CHANNELS, wire));
+            for (int c = 0; c < BENCH_CHANNELS; c++)
+            {
+                if (shimPwm(channelPins[c]) == pgm_read_byte(table + level))
+                    continue;
+                printf("curve %d, level %d: pin %d at %d\n", curve, level, channelPins[c], shimPwm(channelPins[c]));
+                errors++;
+            }
+        }
+    }
+    printf("brightness curves: %d mismatches\n", errors);
+    return errors ? 1 : 0;
+}
+
+static bool parseFormat(const char *name, uint8_t *format)
+{
+    if (strcmp(name, "raw") == 0)
+        *format = 0;
+    else if (strcmp(name, "nibble") == 0)
+        *format = PROTOCOL_NIBBLE;
+    else if (strcmp(name, "delta") == 0)
+        *format = PROTOCOL_DELTA;
+    else if (strcmp(name, "delta-nibble") == 0)
+        *format = PROTOCOL_DELTA | PROTOCOL_NIBBLE;
+    else
+        return false;
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    long frames = BENCH_DEFAULT_FRAMES;
+    uint8_t format = PROTOCOL_DELTA;
+    const char *formatName = "delta";
+    unsigned long baud = 0;
+    double fps = 0.0;
+    unsigned long loopUs = BENCH_DEFAULT_LOOP_US;
+    int noise = 0;
+    uint64_t startMs = 0;
+    bool curvesOnly = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            frames = atol(argv[++i]);
+        else if (strcmp(argv[i], "--encoding") == 0 && i + 1 < argc)
+        {
+            formatName = argv[++i];
+            if (!parseFormat(formatName, &format))
+            {
+                fprintf(stderr, "Error: encoding must be raw, nibble, delta or delta-nibble\n");
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--baud") == 0 && i + 1 < argc)
+            baud = (unsigned long)atol(argv[++i]);
+        else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc)
+            fps = atof(argv[++i]);
+        else if (strcmp(argv[i], "--loop-us") == 0 && i + 1 < argc)
+            loopUs = (unsigned long)atol(argv[++i]);
+        else if (strcmp(argv[i], "--noise") == 0 && i + 1 < argc)
+            noise = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--start-ms") == 0 && i + 1 < argc)
+            startMs = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--check-curves") == 0)
+            curvesOnly = true;
+    }
+
+    shimReset();
+    shimAdvance(startMs * 1000);
+    const uint64_t startUs = shimNow();
+    setup();
+    shimSetPwmHook(onPwm);
+    if (curvesOnly)
+        return checkCurves();
+    srand(1);
+
+    ProtocolEncoder encoder;
+    protocolEncoderInit(&encoder, format, 32);
+    uint8_t levels[BENCH_CHANNELS] = {0};
+    uint8_t expected[BENCH_CHANNELS];
+    uint8_t wire[PROTOCOL_MAX_FRAME];
+    uint8_t wireSize = 0;
+    uint8_t wirePos = 0;
+
+    const double byteUs = baud ? 10e6 / baud : 0.0;
+    const double frameUs = fps > 0.0 ? 1e6 / fps : 0.0;
+    double nextFrameTime = (double)startUs;
+    double nextByteTime = (double)startUs;
+
+    long framesSent = 0;
+    unsigned long long bytesSent = 0;
+    unsigned long long lostBytes = 0;
+    unsigned long long loops = 0;
+    uint8_t discard[64];
+    uint16_t lastOk = 0, lastBad = 0, lastDropped = 0, lastLate = 0;
+    unsigned long long framesOk = 0, framesBad = 0, deltasDropped = 0, framesLate = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    while (framesSent < frames || wirePos < wireSize)
+    {
+        const double now = (double)shimNow();
+        for (;;)
+        {
+            if (wirePos == wireSize)
+            {
+                if (framesSent == frames || (frameUs > 0.0 && now < nextFrameTime))
+                    break;
+                nextLevels(levels);
+                wireSize = protocolEncodeLevels(&encoder, levels, BENCH_CHANNELS, wire);
+                wirePos = 0;
+                for (int c = 0; c < BENCH_CHANNELS; c++)
+                    expected[c] = protocolQuantize(levels[c], format);
+                framesSent++;
+                // Кадр уходит в линию, как только она свободна и кадр готов
+                nextByteTime = std::max(nextByteTime, nextFrameTime);
+                nextFrameTime += frameUs;
+            }
+
+            // Без ограничения скорости линия ждёт, пока loop() заберёт кадр
+            if (baud == 0 ? usartRx.ready : nextByteTime > now)
+                break;
+
+            uint8_t byte = wire[wirePos++];
+            if (noise > 0 && rand() % noise == 0)
+                byte ^= (uint8_t)(1 << (rand() % 8));
+            if (!shimSerialReceive(byte))
+                lostBytes++;
+            bytesSent++;
+            // Байт принят целиком к nextByteTime; без ограничения — прямо сейчас
+            const uint64_t arrived = baud ? (uint64_t)nextByteTime : shimNow();
+            nextByteTime += byteUs;
+
+            if (wirePos == wireSize)
+            {
+                for (int c = 0; c < BENCH_CHANNELS; c++)
+                {
+                    // Прошивка пишет ШИМ, только когда яркость растёт
+                    pending[c] = expected[c] > fadeLevel((uint8_t)c);
+                    pendingLevel[c] = expected[c];
+                    pendingSince[c] = arrived;
+                }
+            }
+        }
+
+        loop();
+        loops++;
+        shimSerialTake(discard, sizeof(discard));
+        shimAdvance(loopUs);
+        accumulate(usartFramesOk(), &lastOk, &framesOk);
+        accumulate(usartFramesBad(), &lastBad, &framesBad);
+        accumulate(received.deltasDropped, &lastDropped, &deltasDropped);
+        accumulate(usartRx.framesDropped, &lastLate, &framesLate);
+    }
+    // Дать прошивке разобрать хвост
+    for (int i = 0; i < 16; i++)
+    {
+        loop();
+        shimAdvance(loopUs);
+    }
+    accumulate(usartFramesOk(), &lastOk, &framesOk);
+    accumulate(usartFramesBad(), &lastBad, &framesBad);
+    accumulate(received.deltasDropped, &lastDropped, &deltasDropped);
+    accumulate(usartRx.framesDropped, &lastLate, &framesLate);
+    const double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const double virtualSeconds = (shimNow() - startUs) / 1e6;
+
+    printf("encoding %s, ", formatName);
+    if (baud == 0)
+        printf("unlimited line");
+    else if (fps > 0.0)
+        printf("%lu baud at %.0f frames/s", baud, fps);
+    else
+        printf("%lu baud, back-to-back frames", baud);
+    printf(", loop() = %lu us virtual\n", loopUs);
+
+    printf("frames sent %ld, decoded %llu, bad %llu, deltas dropped %llu, lost before loop() %llu, bytes lost %llu\n",
+           framesSent, framesOk, framesBad, deltasDropped, framesLate, lostBytes);
+    printf("wire %.2f bytes/frame\n", framesSent ? (double)bytesSent / framesSent : 0.0);
+    printf("wall %.3f s: %.0f loop()/s, %.0f frames/s\n", wallSeconds, loops / wallSeconds, framesSent / wallSeconds);
+    printf("virtual %.3f s: %.0f frames/s on the simulated board\n", virtualSeconds,
+           virtualSeconds > 0.0 ? framesSent / virtualSeconds : 0.0);
+
+    if (!latencies.empty())
+    {
+        std::sort(latencies.begin(), latencies.end());
+        double sum = 0.0;
+        for (unsigned long l : latencies)
+            sum += l;
+        printf("frame-to-PWM latency over %zu writes: mean %.1f us, p50 %lu us, p99 %lu us, max %lu us\n",
+               latencies.size(), sum / latencies.size(), latencies[latencies.size() / 2],
+               latencies[latencies.size() * 99 / 100], latencies.back());
+    }
+    if (fadeSteps > 0)
+    {
+        printf("fade steps %llu: interval mean %.1f us, min %llu us, max %llu us (tick %d us)\n", fadeSteps,
+               (double)fadeSum / fadeSteps, (unsigned long long)fadeMin, (unsigned long long)fadeMax, FADE_TICK_US);
+    }
+    return 0;
+}
@@ -0,0 +1,16 @@
+// Перевод яркости из кадра в скважность ШИМ. Линейная яркость на светодиоде
+// выглядит слишком яркой внизу и плоской вверху: таблицы по 256 значений
+// лежат во флеше, запись в ШИМ — одно чтение LPM без вычислений с плавающей точкой.
+// Кривая выбирается для каждого канала: по умолчанию при сборке, на ходу —
+// командой PROTOCOL_CMD_SET_CURVE.
+#pragma once
+#include <Arduino.h>
+#include "shared_protocol.h"
+
+// Кривая после включения: -D BRIGHTNESS_DEFAULT_CURVE=PROTOCOL_CURVE_GAMMA в build_flags
+#ifndef BRIGHTNESS_DEFAULT_CURVE
+#define BRIGHTNESS_DEFAULT_CURVE PROTOCOL_CURVE_CIE
+#endif
+
+// Таблица в PROGMEM (читать через pgm_read_byte) или 0 для неизвестной кривой
+const uint8_t *brightnessTable(uint8_t curve);
@@ -0,0 +1,177 @@
+#include <Arduino.h>
+#include "fade_engine.h"
+#include "brightness_curves.h"
+
+// analogWrite меняет общие регистры таймеров чтением-записью: из loop()
+// пишем только с запретом прерываний, иначе тик может вклиниться посередине.
+// На ПК прерываний нет, блок просто выполняется
+#if defined(__AVR__)
+#include <util/atomic.h>
+#define FADE_ATOMIC() ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+#else
+#define FADE_ATOMIC()
+#endif
+
+static FadeChannel channels[FADE_MAX_CHANNELS];
+static uint8_t channelCount = 0;
+
+#if defined(__AVR__)
+// Регистр, в который analogWrite пишет скважность вывода. 0 — вывод без
+// аппаратного ШИМ или таймер, которого эта функция не знает
+static volatile uint8_t *compareRegister(uint8_t pin, bool *wide)
+{
+    *wide = false;
+    switch (digitalPinToTimer(pin))
+    {
+#if defined(OCR0A)
+    case TIMER0A:
+        return &OCR0A;
+#endif
+#if defined(OCR0B)
+    case TIMER0B:
+        return &OCR0B;
+#endif
+#if defined(OCR1A)
+    case TIMER1A:
+        *wide = true;
+        return (volatile uint8_t *)&OCR1A;
+#endif
+#if defined(OCR1B)
+    case TIMER1B:
+        *wide = true;
+        return (volatile uint8_t *)&OCR1B;
+#endif
+#if defined(OCR2A)
+    case TIMER2A:
+        return &OCR2A;
+#endif
+#if defined(OCR2B)
+    case TIMER2B:
+        return &OCR2B;
+#endif
+    default:
+        return 0;
+    }
+}
+#else
+// На ПК все записи идут через analogWrite заменителя
+static volatile uint8_t *compareRegister(uint8_t, bool *wide)
+{
+    *wide = false;
+    return 0;
+}
+#endif
+
+// Из loop(): analogWrite сам включает и выключает ШИМ на выводе
+static void writeLevel(FadeChannel &item)
+{
+    item.duty = pgm_read_byte(item.table + item.level);
+    analogWrite(item.pin, item.duty);
+}
+
+// Из прерывания. 0 и 255 analogWrite выводит без ШИМ (digitalWrite), поэтому
+// регистр сравнения действует, только если ШИМ включён и остаётся включённым
+static void stepLevel(FadeChannel &item)
+{
+    const uint8_t duty = pgm_read_byte(item.table + item.level);
+    const bool pwmStays = item.duty != 0 && item.duty != 255 && duty != 0 && duty != 255;
+    item.duty = duty;
+    if (!item.ocr || !pwmStays)
+    {
+        analogWrite(item.pin, duty);
+        return;
+    }
+    if (item.ocrWide)
+        item.ocr[1] = 0;
+    item.ocr[0] = duty;
+}
+
+void fadeBegin(const uint8_t *pins, uint8_t count)
+{
+    channelCount = min(count, (uint8_t)FADE_MAX_CHANNELS);
+    for (uint8_t i = 0; i < channelCount; i++)
+    {
+        channels[i].pin = pins[i];
+        channels[i].level = 0;
+        channels[i].elapsed = 0;
+        channels[i].curve = BRIGHTNESS_DEFAULT_CURVE;
+        channels[i].table = brightnessTable(BRIGHTNESS_DEFAULT_CURVE);
+        channels[i].ocr = compareRegister(pins[i], &channels[i].ocrWide);
+        pinMode(pins[i], OUTPUT);
+        writeLevel(channels[i]);
+    }
+    fadeTimerStart();
+}
+
+void fadeRaise(uint8_t channel, uint8_t level)
+{
+    if (channel >= channelCount)
+        return;
+    FADE_ATOMIC()
+    {
+        FadeChannel &item = channels[channel];
+        if (item.level < level)
+        {
+            item.level = level;
+            item.elapsed = 0;
+            writeLevel(item);
+        }
+    }
+}
+
+uint8_t fadeLevel(uint8_t channel)
+{
+    return channel < channelCount ? channels[channel].level : 0;
+}
+
+bool fadeSetCurve(uint8_t channel, uint8_t curve)
+{
+    const uint8_t *table = brightnessTable(curve);
+    if (channel >= channelCount || !table)
+        return false;
+    FADE_ATOMIC()
+    {
+        FadeChannel &item = channels[channel];
+        item.curve = curve;
+        item.table = table;
+        writeLevel(item);
+    }
+    return true;
+}
+
+uint8_t fadeCurve(uint8_t channel)
+{
+    return channel < channelCount ? channels[channel].curve : 0;
+}
+
+void fadeTick()
+{
+    for (uint8_t i = 0; i < channelCount; i++)
+    {
+        FadeChannel &item = channels[i];
+        item.elapsed += FADE_TICK_UNITS;
+        if (item.elapsed < FADE_INTERVAL_UNITS)
+            continue;
+
+        // Остаток переносится: шаги идут ровно через FADE_INTERVAL_US
+        item.elapsed -= FADE_INTERVAL_UNITS;
+        if (item.level == 0)
+            continue;
+        item.level >>= 1;
+        stepLevel(item);
+    }
+}
+
+#if defined(__AVR__)
+ISR(TIMER0_COMPA_vect)
+{
+    fadeTick();
+}
+
+void fadeTimerStart()
+{
+    // Ядро Arduino настроило Timer0 на делитель 64; OCR0A меняет только
+    // analogWrite(6), а совпадение всё равно случается раз за период
+    TIMSK0 |= _BV(OCIE0A);
+}
+#endif
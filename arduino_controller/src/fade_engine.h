@@ -0,0 +1,47 @@
+// Затухание каналов по прерыванию таймера, а не по millis() в loop().
+// Тик — совпадение Timer0 с OCR0A, раз за период счётчика: 64 * 256 тактов
+// на 16 МГц, 1024 мкс (~976 Гц). Timer0 уже считает millis() и даёт ШИМ на
+// выводах 5 и 6; прерывание по совпадению раз за период не мешает ни тому,
+// ни другому. Абсолютного времени здесь нет: каждый канал считает, сколько
+// прошло с последнего шага, поэтому переполнения счётчиков не бывает.
+// Шаг затухания внутри диапазона ШИМ — одна запись в регистр сравнения
+// таймера; полный analogWrite только при включении и выключении вывода.
+#pragma once
+#include <stdint.h>
+
+#define FADE_MAX_CHANNELS 8
+#define FADE_TICK_US 1024
+// Через столько после подъёма яркость уменьшается вдвое, и дальше с тем же шагом
+#define FADE_INTERVAL_US 80000UL
+// Прошедшее время в единицах 8 мкс: 80 мс влезают в 16 бит, тик — целое число
+#define FADE_UNIT_US 8
+#define FADE_TICK_UNITS (FADE_TICK_US / FADE_UNIT_US)
+#define FADE_INTERVAL_UNITS ((uint16_t)(FADE_INTERVAL_US / FADE_UNIT_US))
+
+struct FadeChannel
+{
+    uint8_t pin;
+    uint8_t level;
+    uint16_t elapsed;      // С последнего подъёма или шага затухания, в FADE_UNIT_US
+    uint8_t curve;         // PROTOCOL_CURVE_*
+    const uint8_t *table;  // brightnessTable(curve), во флеше
+    uint8_t duty;          // Последнее записанное на вывод значение
+    volatile uint8_t *ocr; // Младший байт регистра сравнения вывода; 0 — только analogWrite
+    bool ocrWide;          // 16-битный OCR1x: старший байт пишется первым
+};
+
+// Выводы каналов по порядку; все гаснут с кривой BRIGHTNESS_DEFAULT_CURVE, тик запускается
+void fadeBegin(const uint8_t *pins, uint8_t count);
+// Из loop(): яркость только растёт, затухание отсчитывается заново
+void fadeRaise(uint8_t channel, uint8_t level);
+uint8_t fadeLevel(uint8_t channel);
+// Неизвестная кривая — false, канал остаётся как был
+bool fadeSetCurve(uint8_t channel, uint8_t curve);
+uint8_t fadeCurve(uint8_t channel);
+
+// Тело прерывания таймера
+void fadeTick();
+
+// Железо: на AVR — Timer0 в fade_engine.cpp, на ПК — заменитель
+// из native/arduino_shim.cpp, который зовёт fadeTick() по виртуальному времени
+void fadeTimerStart();
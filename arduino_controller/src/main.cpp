@@ -1,74 +1,83 @@
 #include <Arduino.h>
+#include "fade_engine.h"
 #include "shared_protocol.h"
+#include "usart_rx.h"
 
-const int fadeInterval = 80;
-decltype(millis()) nextFadeTime = 0;
+// Выводы ШИМ по каналам; яркость и затухание ведёт fade_engine
+const uint8_t pinMap[] = {3, 5, 6, 9, 10, 11};
+const uint8_t pinMapSize = static_cast<uint8_t>(sizeof(pinMap) / sizeof(pinMap[0]));
+
+ProtocolLevels received;
+LinkState serialLink;
+uint8_t reply[PROTOCOL_MAX_FRAME];
+
+// SET_CURVE: одна кривая всем каналам или по кривой на канал; в ответ — что стоит теперь
+uint8_t setCurves(const ProtocolDecoder *frame)
+{
+    uint8_t curves[pinMapSize];
+    for (uint8_t i = 0; i < pinMapSize; i++)
+        curves[i] = fadeCurve(i);
+    const uint8_t replySize = protocolApplyCurves(frame, curves, pinMapSize, reply);
+    for (uint8_t i = 0; i < pinMapSize; i++)
+        if (curves[i] != fadeCurve(i))
+            fadeSetCurve(i, curves[i]);
+    return replySize;
+}
+
+// Ответ уже ушёл: дожидаемся конца передачи и перенастраиваем USART
+void setBaud(uint32_t baud)
+{
+    usartFlush();
+    usartBegin(baud);
+}
 
 void setup()
 {
-    Serial.begin(115200);
-    nextFadeTime = millis() + fadeInterval;
+    usartBegin(PROTOCOL_BASE_BAUD);
+    protocolLevelsInit(&received);
+    linkInit(&serialLink, F_CPU, millis());
+    fadeBegin(pinMap, pinMapSize);
     pinMode(LED_BUILTIN, OUTPUT);
     digitalWrite(LED_BUILTIN, LOW);
 }
 
-// Описываем тип данных (как интерфейс в TS)
-struct PinData
-{
-    int key;
-    uint8_t val;
-    decltype(millis()) nextFadeTime;
-};
-PinData pinMap[] = {
-    {3, 0, nextFadeTime},
-    {5, 0, nextFadeTime},
-    {6, 0, nextFadeTime},
-    {9, 0, nextFadeTime},
-    {10, 0, nextFadeTime},
-    {11, 0, nextFadeTime},
-};
-const uint8_t pinMapSize = static_cast<uint8_t>(sizeof(pinMap) / sizeof(pinMap[0]));
-
 void loop()
 {
-    // Timer
     const auto currentTime = millis();
-    if (currentTime >= nextFadeTime)
-    {
-        const auto requiredNextFadeTime = currentTime + fadeInterval;
-        auto tempNextFadeTime = pinMap[0].nextFadeTime;
 
-        for (auto &item : pinMap)
+    // Input: кадры протокола v2 собирает прерывание приёма, здесь только готовые
+    const ProtocolDecoder *frame = usartTakeFrame();
+    if (frame)
+    {
+        uint32_t switchTo = 0;
+        // Счётчики приёма уходят на ПК в ответе на HELLO
+        if (protocolControlCommand(frame) == PROTOCOL_CMD_HELLO)
         {
-            if (item.nextFadeTime > currentTime)
-            {
-                tempNextFadeTime = min(tempNextFadeTime, item.nextFadeTime);
-                continue;
-            }
-
-            item.val >>= 1;
-            item.nextFadeTime = requiredNextFadeTime;
-            analogWrite(item.key, item.val);
+            serialLink.rxOverruns = usartOverruns();
+            serialLink.rxBad = usartFramesBad();
         }
+        uint8_t replySize = linkOnFrame(&serialLink, frame, currentTime, reply, &switchTo);
+        if (protocolControlCommand(frame) == PROTOCOL_CMD_SET_CURVE)
+            replySize = setCurves(frame);
+        if (replySize > 0)
+            usartWrite(reply, replySize);
 
-        nextFadeTime = min(requiredNextFadeTime, tempNextFadeTime);
+        if (protocolApplyFrame(frame, &received))
+        {
+            // Лишние каналы (раздельный анализ на ПК) отбрасываем
+            const uint8_t *levels = received.levels;
+            const uint8_t count = min(received.count, pinMapSize);
+            for (uint8_t i = 0; i < count; i++)
+                fadeRaise(i, levels[i]);
+        }
+        // Слот отдаём до смены скорости: usartBegin сбрасывает оба
+        usartReleaseFrame();
+        if (switchTo != 0)
+            setBaud(switchTo);
     }
 
-    // Input
-
-    if (Serial.available() < pinMapSize + 1)
-        return;
-    if (Serial.read() != 0xFE)
-        return;
-
-    for (auto &item : pinMap)
-    {
-        const uint8_t temp_val = Serial.read();
-        if (item.val >= temp_val)
-            continue;
-
-        item.val = temp_val;
-        item.nextFadeTime = currentTime + fadeInterval;
-        analogWrite(item.key, item.val);
-    }
+    // Проверка новой скорости не завершилась или ПК пропал: назад
+    const uint32_t fallback = linkPoll(&serialLink, millis());
+    if (fallback != 0)
+        setBaud(fallback);
 }
\ No newline at end of file
@@ -0,0 +1,140 @@
+#include "usart_rx.h"
+
+// Данные слота читаются только после проверки ready: компилятор не должен
+// поднимать эти чтения выше
+#define USART_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+// AVR читает 16 бит за две команды: прерывание не должно влезть между ними.
+// На ПК прерываний нет, блок просто выполняется
+#if defined(__AVR__)
+#include <util/atomic.h>
+#define USART_ATOMIC() ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+#else
+#define USART_ATOMIC()
+#endif
+
+UsartRx usartRx;
+
+void usartReset()
+{
+    protocolDecoderReset(&usartRx.slots[0]);
+    protocolDecoderReset(&usartRx.slots[1]);
+    usartRx.filling = 0;
+    usartRx.ready = false;
+}
+
+void usartReceive(uint8_t byte)
+{
+    ProtocolDecoder *decoder = &usartRx.slots[usartRx.filling];
+    if (!protocolDecode(decoder, byte))
+        return;
+
+    // Пока loop() не забрал готовый кадр, его слот трогать нельзя:
+    // новый кадр теряется, протокол переживает это как пропуск
+    if (usartRx.ready)
+    {
+        usartRx.framesDropped++;
+        return;
+    }
+    usartRx.filling ^= 1;
+    usartRx.ready = true;
+}
+
+const ProtocolDecoder *usartTakeFrame()
+{
+    if (!usartRx.ready)
+        return 0;
+    USART_BARRIER();
+    // Прерывание меняет filling, только когда ready сброшен
+    return &usartRx.slots[usartRx.filling ^ 1];
+}
+
+void usartReleaseFrame()
+{
+    USART_BARRIER();
+    usartRx.ready = false;
+}
+
+uint16_t usartFramesOk()
+{
+    uint16_t count = 0;
+    USART_ATOMIC()
+    {
+        count = usartRx.slots[0].framesOk + usartRx.slots[1].framesOk;
+    }
+    return count;
+}
+
+uint16_t usartFramesBad()
+{
+    uint16_t count = 0;
+    USART_ATOMIC()
+    {
+        count = usartRx.slots[0].framesBad + usartRx.slots[1].framesBad;
+    }
+    return count;
+}
+
+uint16_t usartOverruns()
+{
+    uint16_t count = 0;
+    USART_ATOMIC()
+    {
+        count = usartRx.overruns;
+    }
+    return count;
+}
+
+#if defined(__AVR__)
+#include <avr/interrupt.h>
+#include <avr/io.h>
+
+// HardwareSerial не используется: иначе ядро Arduino подтянет свой вектор USART_RX
+ISR(USART_RX_vect)
+{
+    // Флаги ошибок читаются до UDR0: чтение данных их сбрасывает
+    if (UCSR0A & _BV(DOR0))
+        usartRx.overruns++;
+    usartReceive(UDR0);
+}
+
+static bool txStarted = false;
+
+void usartBegin(uint32_t baud)
+{
+    UCSR0B = 0;
+    usartReset();
+    txStarted = false;
+
+    // Делитель с округлением, как в protocolBaudSupported
+    const uint32_t divisor = (F_CPU / 4 / baud + 1) / 2;
+    UCSR0A = _BV(U2X0);
+    UBRR0 = (uint16_t)(divisor - 1);
+    UCSR0C = _BV(UCSZ01) | _BV(UCSZ00);
+    UCSR0B = _BV(RXEN0) | _BV(TXEN0) | _BV(RXCIE0);
+}
+
+void usartWrite(const uint8_t *data, uint8_t size)
+{
+    for (uint8_t i = 0; i < size; i++)
+    {
+        while (!(UCSR0A & _BV(UDRE0)))
+        {
+        }
+        // TXC0 сбрасывается записью единицы; U2X0 сохраняем
+        UCSR0A = (uint8_t)((UCSR0A & _BV(U2X0)) | _BV(TXC0));
+        UDR0 = data[i];
+    }
+    txStarted = txStarted || size > 0;
+}
+
+void usartFlush()
+{
+    // TXC0 не встанет, если с настройки ничего не отправляли
+    if (!txStarted)
+        return;
+    while (!(UCSR0A & _BV(TXC0)))
+    {
+    }
+}
+#endif
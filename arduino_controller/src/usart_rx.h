@@ -0,0 +1,45 @@
+// Приём кадров протокола v2 прямо в прерывании USART RX, без HardwareSerial.
+// Прерывание разбирает каждый байт сразу, как он пришёл, и собирает кадр в
+// одном из двух слотов; loop() забирает только целые кадры из другого.
+// Задержка приёма кадра не зависит от того, сколько длится loop().
+#pragma once
+#include <stdint.h>
+#include "shared_protocol.h"
+
+struct UsartRx
+{
+    ProtocolDecoder slots[2];
+    volatile uint8_t filling;         // Слот, который заполняет прерывание
+    volatile bool ready;              // В slots[filling ^ 1] лежит непрочитанный кадр
+    volatile uint16_t framesDropped;  // Кадр готов, а loop() не забрал предыдущий
+    volatile uint16_t overruns;       // Байт потерян в самом USART (DOR)
+};
+
+extern UsartRx usartRx;
+
+// Железо: на AVR — регистры USART0 в usart_rx.cpp, на ПК — заменитель
+// из native/arduino_shim.cpp
+
+// Настраивает USART на 8N1 с удвоением скорости (U2X) и сбрасывает приём
+void usartBegin(uint32_t baud);
+// Передача без буфера: ответы короткие и редкие, приём в это время идёт
+void usartWrite(const uint8_t *data, uint8_t size);
+// Ждёт, пока последний байт уйдёт из сдвигового регистра
+void usartFlush();
+
+// Не зависит от железа
+
+// Сброс обоих слотов; вызывается из usartBegin, пока приёмник выключен
+void usartReset();
+// Тело прерывания RX: один байт с линии
+void usartReceive(uint8_t byte);
+
+// Целый кадр или 0. Кадр принадлежит loop() до usartReleaseFrame
+const ProtocolDecoder *usartTakeFrame();
+void usartReleaseFrame();
+
+// Счётчики обоих слотов вместе. Их меняет прерывание, поэтому 16-битное
+// значение читается с запретом прерываний
+uint16_t usartFramesOk();
+uint16_t usartFramesBad();
+uint16_t usartOverruns();
@@ -1,6 +1,9 @@
 // common/shared_protocol.h
 #pragma once
 #include <stdint.h>
+#if defined(__AVR__)
+#include <util/crc16.h>
+#endif
 
 // Общие константы
 const uint16_t SYNC_WORD = 0xA55A;
@@ -16,4 +19,671 @@ struct AudioDataPacket {
     int16_t amplitude;   // 2 байта
 };
 
-#pragma pack(pop) // Возвращаем стандартное выравнивание
\ No newline at end of file
+#pragma pack(pop) // Возвращаем стандартное выравнивание
+
+// === Протокол v2: кадры яркостей ===
+//
+// Полезная нагрузка кадра:
+//   [версия][номер кадра][формат][число каналов N][данные][CRC-16 старший][CRC-16 младший]
+// На линии она закодирована COBS (внутри кадра нет нулей) и завершается
+// байтом 0x00. Приёмник после любого мусора синхронизируется на следующем нуле,
+// то есть теряет не больше одного кадра.
+//
+// CRC-16/CCITT-FALSE (многочлен 0x1021, начальное 0xFFFF) считается по
+// заголовку и данным. CRC, посчитанный по всей нагрузке вместе с самой
+// суммой, равен нулю — так приёмник проверяет её побайтово.
+//
+// Формат — флаги, каждый кадр описывает себя сам, так что приёмник понимает
+// любой выбор передатчика без согласования:
+//   0                   — N байтов яркости;
+//   PROTOCOL_NIBBLE     — по 4 бита на канал, два канала в байте (старшая тетрада первой);
+//   PROTOCOL_DELTA      — изменения относительно кадра с номером на единицу меньше:
+//                         токен t < 0x80 — за ним t + 1 новых значений подряд,
+//                         t >= 0x80 — пропуск (t & 0x7F) + 1 неизменных каналов.
+//                         Каналы после последнего токена не изменились.
+// С NIBBLE | DELTA значения в токенах тоже упакованы по 4 бита.
+//
+// Код без STL и динамической памяти: собирается и на ПК, и на AVR.
+
+const uint8_t PROTOCOL_VERSION = 2;
+const uint8_t PROTOCOL_DELIMITER = 0x00;
+const uint8_t PROTOCOL_MAX_CHANNELS = 32;
+const uint8_t PROTOCOL_HEADER_SIZE = 4;
+const uint8_t PROTOCOL_CRC_SIZE = 2;
+// Худший случай — дельта, где меняется каждый второй канал: токен на каждый канал
+const uint8_t PROTOCOL_MAX_DATA = 2 * PROTOCOL_MAX_CHANNELS;
+const uint8_t PROTOCOL_MAX_PAYLOAD = PROTOCOL_HEADER_SIZE + PROTOCOL_MAX_DATA + PROTOCOL_CRC_SIZE;
+// Нагрузка короче 254 байт, поэтому COBS добавляет ровно один байт; плюс разделитель
+const uint8_t PROTOCOL_MAX_FRAME = PROTOCOL_MAX_PAYLOAD + 2;
+
+const uint8_t PROTOCOL_NIBBLE = 0x01;
+const uint8_t PROTOCOL_DELTA = 0x02;
+const uint8_t PROTOCOL_FORMAT_MASK = PROTOCOL_NIBBLE | PROTOCOL_DELTA;
+
+const uint8_t PROTOCOL_DELTA_SKIP = 0x80;
+const uint8_t PROTOCOL_MAX_RUN = 0x80;
+
+inline uint16_t protocolCrc16Update(uint16_t crc, uint8_t byte)
+{
+#if defined(__AVR__)
+    // Тот же многочлен 0x1021 без отражения, но без цикла по битам:
+    // приёмник зовёт это в прерывании на каждый байт
+    return _crc_xmodem_update(crc, byte);
+#else
+    crc ^= (uint16_t)byte << 8;
+    for (uint8_t bit = 0; bit < 8; bit++)
+        crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    return crc;
+#endif
+}
+
+// Яркость после 4-битного квантования — такой её увидит приёмник
+inline uint8_t protocolQuantize(uint8_t level, uint8_t format)
+{
+    if (!(format & PROTOCOL_NIBBLE))
+        return level;
+    const uint8_t q = level >> 4;
+    return (uint8_t)((q << 4) | q);
+}
+
+// Потоковый COBS: байты пишутся сразу в выходной буфер, блок закрывается,
+// когда встречается ноль или набирается 254 байта
+struct CobsEncoder
+{
+    uint8_t *out;
+    uint8_t codePos; // Где стоит байт-код текущего блока
+    uint8_t pos;
+    uint8_t code;
+    uint16_t crc;    // Сумма по всему, что прошло через protocolPut
+};
+
+inline void cobsBegin(CobsEncoder *encoder, uint8_t *out)
+{
+    encoder->out = out;
+    encoder->codePos = 0;
+    encoder->pos = 1;
+    encoder->code = 1;
+    encoder->crc = 0xFFFF;
+}
+
+inline void cobsPut(CobsEncoder *encoder, uint8_t byte)
+{
+    if (byte != 0)
+    {
+        encoder->out[encoder->pos++] = byte;
+        encoder->code++;
+    }
+    if (byte == 0 || encoder->code == 0xFF)
+    {
+        encoder->out[encoder->codePos] = encoder->code;
+        encoder->codePos = encoder->pos++;
+        encoder->code = 1;
+    }
+}
+
+// Закрывает последний блок и дописывает разделитель; возвращает длину кадра
+inline uint8_t cobsEnd(CobsEncoder *encoder)
+{
+    encoder->out[encoder->codePos] = encoder->code;
+    encoder->out[encoder->pos++] = PROTOCOL_DELIMITER;
+    return encoder->pos;
+}
+
+inline void protocolPut(CobsEncoder *encoder, uint8_t byte)
+{
+    encoder->crc = protocolCrc16Update(encoder->crc, byte);
+    cobsPut(encoder, byte);
+}
+
+// Значения подряд: байтами или тетрадами
+inline void protocolPutValues(CobsEncoder *encoder, const uint8_t *levels, uint8_t count, uint8_t format)
+{
+    if (!(format & PROTOCOL_NIBBLE))
+    {
+        for (uint8_t i = 0; i < count; i++)
+            protocolPut(encoder, levels[i]);
+        return;
+    }
+    for (uint8_t i = 0; i < count; i += 2)
+    {
+        const uint8_t low = i + 1 < count ? levels[i + 1] >> 4 : 0;
+        protocolPut(encoder, (uint8_t)((levels[i] & 0xF0) | low));
+    }
+}
+
+// Состояние передатчика: формат сессии и последний отправленный кадр для дельты
+struct ProtocolEncoder
+{
+    uint8_t format;
+    uint8_t keyframeInterval;     // Полный кадр каждые столько кадров; 0 — только по запросу
+    uint8_t sinceKeyframe;
+    bool needKeyframe;
+    uint8_t sequence;
+    uint8_t count;
+    uint8_t reference[PROTOCOL_MAX_CHANNELS]; // Как кадр увидел приёмник, после квантования
+};
+
+inline void protocolEncoderInit(ProtocolEncoder *encoder, uint8_t format, uint8_t keyframeInterval)
+{
+    encoder->format = format & PROTOCOL_FORMAT_MASK;
+    encoder->keyframeInterval = keyframeInterval;
+    encoder->sinceKeyframe = 0;
+    encoder->needKeyframe = true;
+    encoder->sequence = 0;
+    encoder->count = 0;
+}
+
+// Следующий кадр уйдёт полным: приёмник мог не получить предыдущий
+inline void protocolForceKeyframe(ProtocolEncoder *encoder)
+{
+    encoder->needKeyframe = true;
+}
+
+// Сколько байтов данных займёт дельта к encoder->reference: те же серии, что
+// пишет protocolEncodeLevels, но без записи
+inline uint8_t protocolDeltaSize(const ProtocolEncoder *encoder, const uint8_t *levels, uint8_t count, uint8_t format)
+{
+    uint8_t size = 0;
+    uint8_t i = 0;
+    uint8_t pendingSkip = 0;
+    while (i < count)
+    {
+        if (protocolQuantize(levels[i], format) == encoder->reference[i])
+        {
+            pendingSkip++;
+            i++;
+            continue;
+        }
+        size += (uint8_t)((pendingSkip + PROTOCOL_MAX_RUN - 1) / PROTOCOL_MAX_RUN);
+        pendingSkip = 0;
+        uint8_t run = 1;
+        while (i + run < count && run < PROTOCOL_MAX_RUN &&
+               protocolQuantize(levels[i + run], format) != encoder->reference[i + run])
+            run++;
+        size += (uint8_t)(1 + ((format & PROTOCOL_NIBBLE) ? (run + 1) / 2 : run));
+        i += run;
+    }
+    return size;
+}
+
+// Кодирует кадр прямо из массива яркостей, без промежуточной копии.
+// out — буфер на PROTOCOL_MAX_FRAME байт; count не больше PROTOCOL_MAX_CHANNELS.
+// Дельта, которая вышла бы не короче полного кадра, заменяется полным кадром.
+inline uint8_t protocolEncodeLevels(ProtocolEncoder *encoder, const uint8_t *levels, uint8_t count, uint8_t *out)
+{
+    bool keyframe = encoder->needKeyframe || count != encoder->count ||
+                    (encoder->keyframeInterval != 0 && encoder->sinceKeyframe + 1 >= encoder->keyframeInterval);
+    if (!keyframe && (encoder->format & PROTOCOL_DELTA))
+    {
+        const uint8_t keyframeSize = (encoder->format & PROTOCOL_NIBBLE) ? (uint8_t)((count + 1) / 2) : count;
+        keyframe = protocolDeltaSize(encoder, levels, count, encoder->format) >= keyframeSize;
+    }
+    const uint8_t format = keyframe ? (uint8_t)(encoder->format & ~PROTOCOL_DELTA) : encoder->format;
+
+    CobsEncoder cobs;
+    cobsBegin(&cobs, out);
+    protocolPut(&cobs, PROTOCOL_VERSION);
+    protocolPut(&cobs, encoder->sequence++);
+    protocolPut(&cobs, format);
+    protocolPut(&cobs, count);
+
+    if (!(format & PROTOCOL_DELTA))
+        protocolPutValues(&cobs, levels, count, format);
+    else
+    {
+        // Хвост из неизменных каналов не передаётся вовсе
+        uint8_t i = 0;
+        uint8_t pendingSkip = 0;
+        while (i < count)
+        {
+            if (protocolQuantize(levels[i], format) == encoder->reference[i])
+            {
+                pendingSkip++;
+                i++;
+                continue;
+            }
+            while (pendingSkip > 0)
+            {
+                const uint8_t run = pendingSkip < PROTOCOL_MAX_RUN ? pendingSkip : PROTOCOL_MAX_RUN;
+                protocolPut(&cobs, (uint8_t)(PROTOCOL_DELTA_SKIP | (run - 1)));
+                pendingSkip -= run;
+            }
+            uint8_t run = 1;
+            while (i + run < count && run < PROTOCOL_MAX_RUN &&
+                   protocolQuantize(levels[i + run], format) != encoder->reference[i + run])
+                run++;
+            protocolPut(&cobs, (uint8_t)(run - 1));
+            protocolPutValues(&cobs, levels + i, run, format);
+            i += run;
+        }
+    }
+
+    const uint16_t crc = cobs.crc;
+    cobsPut(&cobs, (uint8_t)(crc >> 8));
+    cobsPut(&cobs, (uint8_t)crc);
+
+    for (uint8_t i = 0; i < count; i++)
+        encoder->reference[i] = protocolQuantize(levels[i], format);
+    encoder->count = count;
+    encoder->sinceKeyframe = keyframe ? 0 : encoder->sinceKeyframe + 1;
+    encoder->needKeyframe = false;
+    return cobsEnd(&cobs);
+}
+
+// Потоковый приёмник: O(1) на байт, CRC считается по ходу. Готовый кадр
+// лежит в payload до следующего вызова protocolDecode.
+struct ProtocolDecoder
+{
+    uint8_t payload[PROTOCOL_MAX_PAYLOAD];
+    uint8_t length;
+    uint8_t blockLeft;    // Сколько байтов данных осталось в текущем блоке COBS
+    bool zeroPending;     // Блок закончился неявным нулём; ставим его, если кадр продолжится
+    bool overflow;        // Кадр длиннее допустимого: ждём разделитель
+    uint16_t crc;
+    uint8_t frameLength;  // Длина нагрузки последнего принятого кадра
+
+    uint16_t framesOk;
+    uint16_t framesBad;   // Ошибки CRC, длины, версии
+};
+
+inline void protocolDecoderReset(ProtocolDecoder *decoder)
+{
+    decoder->length = 0;
+    decoder->blockLeft = 0;
+    decoder->zeroPending = false;
+    decoder->overflow = false;
+    decoder->crc = 0xFFFF;
+}
+
+inline void protocolDecoderInit(ProtocolDecoder *decoder)
+{
+    protocolDecoderReset(decoder);
+    decoder->frameLength = 0;
+    decoder->framesOk = 0;
+    decoder->framesBad = 0;
+}
+
+inline void protocolDecoderAppend(ProtocolDecoder *decoder, uint8_t byte)
+{
+    if (decoder->length >= PROTOCOL_MAX_PAYLOAD)
+    {
+        decoder->overflow = true;
+        return;
+    }
+    decoder->payload[decoder->length++] = byte;
+    decoder->crc = protocolCrc16Update(decoder->crc, byte);
+}
+
+// Возвращает true, когда принят целый кадр с верной суммой
+inline bool protocolDecode(ProtocolDecoder *decoder, uint8_t byte)
+{
+    if (byte == PROTOCOL_DELIMITER)
+    {
+        // Неявный ноль в конце последнего блока не входит в кадр
+        const bool complete = decoder->blockLeft == 0 && !decoder->overflow;
+        const uint8_t length = decoder->length;
+        const bool valid = complete && decoder->crc == 0 &&
+                           length >= PROTOCOL_HEADER_SIZE + PROTOCOL_CRC_SIZE &&
+                           decoder->payload[0] == PROTOCOL_VERSION &&
+                           decoder->payload[3] <= PROTOCOL_MAX_CHANNELS;
+        protocolDecoderReset(decoder);
+        // Пустой кадр — просто разделитель подряд, не ошибка
+        if (valid)
+        {
+            decoder->framesOk++;
+            decoder->frameLength = length;
+        }
+        else if (length > 0 || !complete)
+            decoder->framesBad++;
+        return valid;
+    }
+
+    if (decoder->blockLeft == 0)
+    {
+        if (decoder->zeroPending)
+            protocolDecoderAppend(decoder, 0);
+        decoder->blockLeft = byte - 1;
+        decoder->zeroPending = byte != 0xFF;
+        return false;
+    }
+
+    protocolDecoderAppend(decoder, byte);
+    decoder->blockLeft--;
+    return false;
+}
+
+// Яркости на стороне приёмника: дельта накладывается на предыдущий кадр
+struct ProtocolLevels
+{
+    uint8_t levels[PROTOCOL_MAX_CHANNELS];
+    uint8_t count;
+    uint8_t sequence;
+    bool valid;             // Есть опорный кадр для дельты
+    uint16_t deltasDropped; // Дельты без опорного кадра: ждём полный
+};
+
+inline void protocolLevelsInit(ProtocolLevels *state)
+{
+    state->count = 0;
+    state->sequence = 0;
+    state->valid = false;
+    state->deltasDropped = 0;
+}
+
+// Читает count <= PROTOCOL_MAX_CHANNELS значений подряд из data; false, если данных
+// не хватило. Предел count заодно ограничивает для компилятора запись в levels
+inline bool protocolGetValues(const uint8_t *data, uint8_t size, uint8_t *pos, uint8_t *levels, uint8_t count, uint8_t format)
+{
+    const uint8_t bytes = (format & PROTOCOL_NIBBLE) ? (uint8_t)((count + 1) / 2) : count;
+    if (count > PROTOCOL_MAX_CHANNELS || *pos + bytes > size)
+        return false;
+    const uint8_t *src = data + *pos;
+    if (!(format & PROTOCOL_NIBBLE))
+    {
+        for (uint8_t i = 0; i < count; i++)
+            levels[i] = src[i];
+    }
+    else
+    {
+        for (uint8_t i = 0; i < count; i++)
+        {
+            const uint8_t q = (i & 1) ? (src[i / 2] & 0x0F) : (src[i / 2] >> 4);
+            levels[i] = (uint8_t)((q << 4) | q);
+        }
+    }
+    *pos += bytes;
+    return true;
+}
+
+// Применяет кадр, только что принятый protocolDecode; true, если яркости обновились.
+// Дельта после пропущенного или битого кадра отбрасывается до следующего полного.
+inline bool protocolApplyFrame(const ProtocolDecoder *decoder, ProtocolLevels *state)
+{
+    const uint8_t *payload = decoder->payload;
+    const uint8_t sequence = payload[1];
+    const uint8_t format = payload[2];
+    const uint8_t count = payload[3];
+    const uint8_t *data = payload + PROTOCOL_HEADER_SIZE;
+    const uint8_t size = decoder->frameLength - PROTOCOL_HEADER_SIZE - PROTOCOL_CRC_SIZE;
+    uint8_t pos = 0;
+
+    // protocolDecode уже отсеял такие кадры, но функция не должна на это полагаться
+    if (count > PROTOCOL_MAX_CHANNELS || format & ~PROTOCOL_FORMAT_MASK)
+        return false;
+
+    if (!(format & PROTOCOL_DELTA))
+    {
+        if (!protocolGetValues(data, size, &pos, state->levels, count, format) || pos != size)
+        {
+            state->valid = false;
+            return false;
+        }
+    }
+    else
+    {
+        if (!state->valid || count != state->count || sequence != (uint8_t)(state->sequence + 1))
+        {
+            state->valid = false;
+            state->deltasDropped++;
+            return false;
+        }
+        uint8_t channel = 0;
+        while (pos < size)
+        {
+            const uint8_t token = data[pos++];
+            const uint8_t run = (uint8_t)((token & 0x7F) + 1);
+            if (channel + run > count ||
+                (!(token & PROTOCOL_DELTA_SKIP) && !protocolGetValues(data, size, &pos, state->levels + channel, run, format)))
+            {
+                // Кадр прошёл CRC, но собран неверно: опорному кадру больше не верим
+                state->valid = false;
+                return false;
+            }
+            channel += run;
+        }
+    }
+
+    state->count = count;
+    state->sequence = sequence;
+    state->valid = true;
+    return true;
+}
+
+// === Управляющие кадры и согласование скорости ===
+//
+// Управляющий кадр — формат PROTOCOL_CONTROL, число каналов 0, данные
+// [команда][аргументы]. protocolApplyFrame такие кадры пропускает.
+//
+// Согласование (передатчик начинает на PROTOCOL_BASE_BAUD):
+//   HELLO                -> HELLO [наибольшая скорость платы, u32]
+//                           [байты, потерянные USART, u16][битые кадры, u16]
+//   SET_BAUD [u32]       -> SET_BAUD [u32] на старой скорости, затем обе стороны
+//                           переходят на новую; отказ — ответ с текущей скоростью
+//   VERIFY [шаблон]      -> VERIFY [тот же шаблон] уже на новой скорости
+//   COMMIT               -> COMMIT; скорость закреплена
+// Без COMMIT за PROTOCOL_VERIFY_TIMEOUT_MS после последнего VERIFY плата
+// возвращается на прежнюю скорость. На закреплённой скорости выше базовой
+// плата ждёт хоть один верный кадр каждые PROTOCOL_LINK_TIMEOUT_MS, иначе
+// уходит на базовую: передатчик в тишине шлёт PING.
+//
+// Кривая яркости (можно в любой момент):
+//   SET_CURVE [k]        -> SET_CURVE [кривые всех каналов платы]; k — всем каналам
+//   SET_CURVE [k0 k1 ..] -> то же, но кривая каждому каналу по порядку
+// Неизвестная кривая оставляет канал как был.
+// Все числа — старшим байтом вперёд.
+
+const uint8_t PROTOCOL_CONTROL = 0x80;
+
+const uint8_t PROTOCOL_CMD_HELLO = 1;
+const uint8_t PROTOCOL_CMD_SET_BAUD = 2;
+const uint8_t PROTOCOL_CMD_VERIFY = 3;
+const uint8_t PROTOCOL_CMD_COMMIT = 4;
+const uint8_t PROTOCOL_CMD_PING = 5; // Без ответа
+const uint8_t PROTOCOL_CMD_SET_CURVE = 6;
+
+// Как яркость из кадра переводится в скважность ШИМ на плате
+const uint8_t PROTOCOL_CURVE_LINEAR = 0;
+const uint8_t PROTOCOL_CURVE_GAMMA = 1; // Степень 2.2
+const uint8_t PROTOCOL_CURVE_CIE = 2;   // Светлота CIE 1976 L*
+const uint8_t PROTOCOL_CURVE_COUNT = 3;
+
+const uint32_t PROTOCOL_BASE_BAUD = 115200;
+const uint16_t PROTOCOL_VERIFY_TIMEOUT_MS = 250;
+const uint16_t PROTOCOL_LINK_TIMEOUT_MS = 1000;
+const uint16_t PROTOCOL_KEEPALIVE_MS = 250;
+// Допустимая ошибка делителя USART, в десятых долях процента
+const uint8_t PROTOCOL_MAX_BAUD_ERROR = 25;
+
+// Нули, чередующиеся биты и длинные серии единиц: то, что первым
+// ломается при неточной скорости
+const uint8_t PROTOCOL_VERIFY_SIZE = 16;
+const uint8_t PROTOCOL_VERIFY_PATTERN[PROTOCOL_VERIFY_SIZE] = {
+    0x00, 0xFF, 0x55, 0xAA, 0x01, 0x80, 0x7F, 0xFE, 0x0F, 0xF0, 0x33, 0xCC, 0x00, 0x00, 0xFF, 0xFF};
+
+inline void protocolPutU16(uint8_t *out, uint16_t value)
+{
+    out[0] = (uint8_t)(value >> 8);
+    out[1] = (uint8_t)value;
+}
+
+inline uint16_t protocolGetU16(const uint8_t *in)
+{
+    return (uint16_t)((in[0] << 8) | in[1]);
+}
+
+inline void protocolPutU32(uint8_t *out, uint32_t value)
+{
+    out[0] = (uint8_t)(value >> 24);
+    out[1] = (uint8_t)(value >> 16);
+    out[2] = (uint8_t)(value >> 8);
+    out[3] = (uint8_t)value;
+}
+
+inline uint32_t protocolGetU32(const uint8_t *in)
+{
+    return ((uint32_t)in[0] << 24) | ((uint32_t)in[1] << 16) | ((uint32_t)in[2] << 8) | in[3];
+}
+
+// out — буфер на PROTOCOL_MAX_FRAME байт; size не больше PROTOCOL_MAX_DATA - 1
+inline uint8_t protocolEncodeControl(uint8_t command, const uint8_t *args, uint8_t size, uint8_t *out)
+{
+    CobsEncoder cobs;
+    cobsBegin(&cobs, out);
+    protocolPut(&cobs, PROTOCOL_VERSION);
+    protocolPut(&cobs, 0);
+    protocolPut(&cobs, PROTOCOL_CONTROL);
+    protocolPut(&cobs, 0);
+    protocolPut(&cobs, command);
+    for (uint8_t i = 0; i < size; i++)
+        protocolPut(&cobs, args[i]);
+
+    const uint16_t crc = cobs.crc;
+    cobsPut(&cobs, (uint8_t)(crc >> 8));
+    cobsPut(&cobs, (uint8_t)crc);
+    return cobsEnd(&cobs);
+}
+
+// Команда только что принятого управляющего кадра; 0 — кадр с яркостями
+inline uint8_t protocolControlCommand(const ProtocolDecoder *decoder)
+{
+    if (decoder->payload[2] != PROTOCOL_CONTROL || decoder->frameLength < PROTOCOL_HEADER_SIZE + PROTOCOL_CRC_SIZE + 1)
+        return 0;
+    return decoder->payload[PROTOCOL_HEADER_SIZE];
+}
+
+inline const uint8_t *protocolControlArgs(const ProtocolDecoder *decoder)
+{
+    return decoder->payload + PROTOCOL_HEADER_SIZE + 1;
+}
+
+inline uint8_t protocolControlArgsSize(const ProtocolDecoder *decoder)
+{
+    return decoder->frameLength - PROTOCOL_HEADER_SIZE - PROTOCOL_CRC_SIZE - 1;
+}
+
+// SET_CURVE: меняет curves[count] по аргументам кадра и пишет в reply ответ
+// с кривыми всех count каналов. Неизвестная кривая оставляет канал как был
+inline uint8_t protocolApplyCurves(const ProtocolDecoder *decoder, uint8_t *curves, uint8_t count, uint8_t *reply)
+{
+    const uint8_t *args = protocolControlArgs(decoder);
+    const uint8_t size = protocolControlArgsSize(decoder);
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if (size == 0 || (size > 1 && i >= size))
+            continue;
+        const uint8_t curve = size == 1 ? args[0] : args[i];
+        if (curve < PROTOCOL_CURVE_COUNT)
+            curves[i] = curve;
+    }
+    return protocolEncodeControl(PROTOCOL_CMD_SET_CURVE, curves, count, reply);
+}
+
+// Скорость, которую USART с удвоением (U2X) выдаст от clock без большой ошибки
+inline bool protocolBaudSupported(uint32_t clock, uint32_t baud)
+{
+    if (baud == 0 || baud > clock / 8)
+        return false;
+    const uint32_t divisor = (clock / 4 / baud + 1) / 2; // UBRR + 1, с округлением
+    const uint32_t actual = clock / 8 / divisor;
+    const uint32_t diff = actual > baud ? actual - baud : baud - actual;
+    return diff * 1000 / baud <= PROTOCOL_MAX_BAUD_ERROR;
+}
+
+// Сторона платы: состояние согласования. Время — в миллисекундах от
+// любого монотонного счётчика (millis()); переполнение переживает.
+struct LinkState
+{
+    uint32_t clock;        // Частота тактирования USART
+    uint32_t baud;         // Текущая скорость
+    uint32_t fallbackBaud; // Куда вернуться, если проверка не завершилась
+    bool verifying;
+    uint32_t lastFrame;    // Когда пришёл последний верный кадр или VERIFY
+    // Счётчики приёма для ответа на HELLO: их обновляет тот, кто владеет USART
+    uint16_t rxOverruns;
+    uint16_t rxBad;
+};
+
+inline void linkInit(LinkState *link, uint32_t clock, uint32_t now)
+{
+    link->clock = clock;
+    link->baud = PROTOCOL_BASE_BAUD;
+    link->fallbackBaud = PROTOCOL_BASE_BAUD;
+    link->verifying = false;
+    link->lastFrame = now;
+    link->rxOverruns = 0;
+    link->rxBad = 0;
+}
+
+// Наибольшая стандартная скорость, которую выдержит USART
+inline uint32_t linkMaxBaud(const LinkState *link)
+{
+    const uint32_t rates[] = {2000000, 1000000, 500000, 250000};
+    for (uint8_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++)
+    {
+        if (protocolBaudSupported(link->clock, rates[i]))
+            return rates[i];
+    }
+    return PROTOCOL_BASE_BAUD;
+}
+
+// Вызывается на каждый кадр, принятый protocolDecode. Ответ (если есть)
+// пишется в reply и уходит на текущей скорости; если *switchTo не ноль,
+// после отправки ответа нужно дождаться конца передачи и перейти на неё.
+inline uint8_t linkOnFrame(LinkState *link, const ProtocolDecoder *decoder, uint32_t now, uint8_t *reply, uint32_t *switchTo)
+{
+    *switchTo = 0;
+    link->lastFrame = now;
+
+    const uint8_t command = protocolControlCommand(decoder);
+    const uint8_t *args = protocolControlArgs(decoder);
+    const uint8_t size = command ? protocolControlArgsSize(decoder) : 0;
+    uint8_t out[PROTOCOL_VERIFY_SIZE];
+
+    if (command == PROTOCOL_CMD_HELLO)
+    {
+        protocolPutU32(out, linkMaxBaud(link));
+        protocolPutU16(out + 4, link->rxOverruns);
+        protocolPutU16(out + 6, link->rxBad);
+        return protocolEncodeControl(PROTOCOL_CMD_HELLO, out, 8, reply);
+    }
+    if (command == PROTOCOL_CMD_SET_BAUD && size == 4)
+    {
+        const uint32_t baud = protocolGetU32(args);
+        const bool accept = !link->verifying && protocolBaudSupported(link->clock, baud);
+        protocolPutU32(out, accept ? baud : link->baud);
+        if (accept && baud != link->baud)
+        {
+            link->fallbackBaud = link->baud;
+            link->baud = baud;
+            link->verifying = true;
+            *switchTo = baud;
+        }
+        return protocolEncodeControl(PROTOCOL_CMD_SET_BAUD, out, 4, reply);
+    }
+    if (command == PROTOCOL_CMD_VERIFY && size == PROTOCOL_VERIFY_SIZE)
+        return protocolEncodeControl(PROTOCOL_CMD_VERIFY, args, size, reply);
+    if (command == PROTOCOL_CMD_COMMIT)
+    {
+        link->verifying = false;
+        return protocolEncodeControl(PROTOCOL_CMD_COMMIT, 0, 0, reply);
+    }
+    return 0;
+}
+
+// Вызывается постоянно; не ноль — скорость, на которую надо вернуться
+inline uint32_t linkPoll(LinkState *link, uint32_t now)
+{
+    const uint32_t silence = now - link->lastFrame;
+    uint32_t target = 0;
+    if (link->verifying && silence > PROTOCOL_VERIFY_TIMEOUT_MS)
+        target = link->fallbackBaud;
+    else if (!link->verifying && link->baud != PROTOCOL_BASE_BAUD && silence > PROTOCOL_LINK_TIMEOUT_MS)
+        target = PROTOCOL_BASE_BAUD;
+    if (target == 0)
+        return 0;
+
+    link->baud = target;
+    link->verifying = false;
+    link->lastFrame = now;
+    return target;
+}
@@ -0,0 +1,516 @@
+// Микробенчмарки DSP на синтетических сигналах: стадии кадра по отдельности для
+// всех размеров FFT и числа полос, сравнение ядер и движков.
+// dsp_bench [iterations] [--json file] — JSON для отслеживания регрессий между версиями
+// dsp_bench --levels file.bands.csv... — байты на кадр для форматов протокола на яркостях
+// из пакетного режима (--batch) по записям реальной музыки
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "audio_dsp.h"
+#include "band_map.h"
+#include "cpu_features.h"
+#include "fft_backend.h"
+#include "filter_bank_engine.h"
+#include "level_packet.h"
+#include "spectrum_kernels.h"
+
+#if defined(DSP_X86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+#define BENCH_FFT_SIZE 4096
+#define BENCH_SAMPLE_RATE 44100.0f
+// Итераций для FFT 4096; для других размеров число масштабируется обратно размеру
+#define BENCH_DEFAULT_ITERATIONS 20000
+#define BENCH_MIN_ITERATIONS 200
+
+// Чтобы компилятор не выкинул результат
+static volatile float benchSink;
+
+static std::vector<BandData> defaultBands()
+{
+    return {
+        {0.0f, 150.0f, 1.0f},
+        {150.0f, 400.0f, 1.0f},
+        {400.0f, 1500.0f, 1.0f},
+        {1500.0f, 4000.0f, 1.0f},
+        {4000.0f, 8000.0f, 1.0f},
+        {8000.0f, 22000.0f, 1.0f}};
+}
+
+// Прежний цикл из data_callback: каждый бин против каждой полосы, корень на каждый бин
+static void legacyBandMax(const float *spectrum, const std::vector<BandData> &bands, float *bandMax)
+{
+    for (size_t b = 0; b < bands.size(); b++)
+        bandMax[b] = 0.0f;
+
+    for (int bin = 0; bin <= BENCH_FFT_SIZE / 2; bin++)
+    {
+        float freq = bin * (BENCH_SAMPLE_RATE / (float)BENCH_FFT_SIZE);
+        float r = spectrum[2 * bin];
+        float im = spectrum[2 * bin + 1];
+        float magnitude = sqrtf(r * r + im * im) / (BENCH_FFT_SIZE / 2.0f);
+
+        for (size_t b = 0; b < bands.size(); b++)
+        {
+            if (freq >= bands[b].freqMin && freq < bands[b].freqMax)
+            {
+                if (magnitude > bandMax[b])
+                    bandMax[b] = magnitude;
+            }
+        }
+    }
+}
+
+// Такты берутся из TSC: это опорная частота, а не текущая частота ядра,
+// зато счётчик есть везде и не требует прав
+static unsigned long long readCycles()
+{
+#if defined(DSP_X86)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+struct Timing
+{
+    double ns;     // На вызов
+    double cycles; // На вызов; 0, если счётчика нет
+};
+
+template <typename Fn>
+static Timing measure(Fn fn, int iterations)
+{
+    for (int i = 0; i < iterations / 10 + 1; i++)
+        fn();
+
+    const unsigned long long startCycles = readCycles();
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+        fn();
+    const auto stop = std::chrono::steady_clock::now();
+    const unsigned long long stopCycles = readCycles();
+
+    Timing t;
+    t.ns = std::chrono::duration<double, std::nano>(stop - start).count() / iterations;
+    t.cycles = (double)(stopCycles - startCycles) / iterations;
+    return t;
+}
+
+// Одна строка отчёта: стадия кадра при заданных размере FFT и числе полос
+struct BenchResult
+{
+    const char *stage;
+    int fftSize;
+    int bands; // 0 — стадия не зависит от числа полос
+    int hop;
+    Timing timing;
+};
+
+static std::vector<BenchResult> results;
+
+static void report(const char *stage, int fftSize, int bands, int hop, Timing timing)
+{
+    results.push_back({stage, fftSize, bands, hop, timing});
+    // Такт на сэмпл — на новый сэмпл входа, т.е. на шаг, а не на всё окно
+    printf("%-15s %6d %5d %12.1f %14.0f %12.2f\n", stage, fftSize, bands, timing.ns, 1e9 / timing.ns, timing.cycles / hop);
+}
+
+// Полосы одинаковой ширины в октавах от 20 Гц до 20 кГц
+static std::vector<BandData> logBands(int count)
+{
+    std::vector<BandData> bands(count);
+    const float ratio = powf(1000.0f, 1.0f / count);
+    float low = 20.0f;
+    for (int b = 0; b < count; b++)
+    {
+        bands[b] = {low, low * ratio, 1.0f};
+        low *= ratio;
+    }
+    bands[0].freqMin = 0.0f;
+    return bands;
+}
+
+// Запоминает последний кадр движка
+struct LastFrameSink : FrameSink
+{
+    uint8_t levels[MAX_BANDS] = {};
+    size_t frames = 0;
+
+    void onFrame(const uint8_t *frameLevels, size_t count) override
+    {
+        for (size_t b = 0; b < count; b++)
+            levels[b] = frameLevels[b];
+        frames++;
+    }
+};
+
+static std::vector<float> makeTone(float freq, float amplitude, size_t count)
+{
+    std::vector<float> x(count);
+    for (size_t i = 0; i < count; i++)
+        x[i] = amplitude * sinf(2.0f * 3.14159265f * freq * i / BENCH_SAMPLE_RATE);
+    return x;
+}
+
+// Стоимость движка в нс на секунду звука и расхождение уровней с эталонным FFT 4096
+static void benchEngines(const std::vector<BandData> &bands)
+{
+    std::unique_ptr<BandEngine> fft = makeFftEngine(BENCH_FFT_SIZE);
+    FilterBankEngine iir;
+    BandEngine *engines[] = {fft.get(), &iir};
+    const char *names[] = {"fft-4096", "iir-bank"};
+
+    // Шум на 10 секунд: одинаковая нагрузка для обоих движков
+    std::vector<float> noise((size_t)BENCH_SAMPLE_RATE * 10);
+    for (float &v : noise)
+        v = (float)rand() / RAND_MAX - 0.5f;
+
+    printf("\nengine      hop   ms per 1 s of audio\n");
+    for (int e = 0; e < 2; e++)
+    {
+        engines[e]->setBands(bands);
+        engines[e]->setHopSize(DEFAULT_HOP_SIZE);
+        LastFrameSink sink;
+
+        const auto start = std::chrono::steady_clock::now();
+        engines[e]->process(noise.data(), noise.size(), sink);
+        const auto stop = std::chrono::steady_clock::now();
+
+        const double ms = std::chrono::duration<double, std::milli>(stop - start).count() / 10.0;
+        printf("%-10s %4d %10.3f\n", names[e], engines[e]->hopSize(), ms);
+    }
+
+    // Точность: тоны по логарифмической сетке, сравниваем установившиеся уровни
+    printf("\ntone Hz   fft levels                  iir levels                  max diff\n");
+    double diffSum = 0.0;
+    int diffCount = 0;
+    for (float freq = 40.0f; freq < 20000.0f; freq *= 2.0f)
+    {
+        const std::vector<float> tone = makeTone(freq, 0.5f, (size_t)(BENCH_SAMPLE_RATE / 2));
+        LastFrameSink sinks[2];
+        for (int e = 0; e < 2; e++)
+        {
+            engines[e]->setBands(bands); // Сбрасывает состояние между тонами
+            engines[e]->process(tone.data(), tone.size(), sinks[e]);
+        }
+
+        int maxDiff = 0;
+        printf("%7.0f  ", freq);
+        for (int e = 0; e < 2; e++)
+        {
+            for (size_t b = 0; b < bands.size(); b++)
+                printf("%3d ", sinks[e].levels[b]);
+            printf("   ");
+        }
+        for (size_t b = 0; b < bands.size(); b++)
+        {
+            const int diff = abs((int)sinks[0].levels[b] - (int)sinks[1].levels[b]);
+            maxDiff = diff > maxDiff ? diff : maxDiff;
+            diffSum += diff;
+            diffCount++;
+        }
+        printf("%4d\n", maxDiff);
+    }
+    printf("mean abs level difference: %.1f of 255\n", diffSum / diffCount);
+}
+
+// Сводный генератор: тон + шум, чтобы в полосы попадали и пики, и фон
+static std::vector<float> makeSignal(size_t count)
+{
+    std::vector<float> x = makeTone(1000.0f, 0.3f, count);
+    for (float &v : x)
+        v += ((float)rand() / RAND_MAX - 0.5f) * 0.1f;
+    return x;
+}
+
+// Стадии кадра AudioDSP по отдельности, затем кадр целиком
+template <int N>
+static void benchFftSize(int baseIterations, const std::vector<int> &bandCounts)
+{
+    const int iterations = std::max(BENCH_MIN_ITERATIONS, (int)((long long)baseIterations * BENCH_FFT_SIZE / N));
+    const int hop = N < DEFAULT_HOP_SIZE ? N : DEFAULT_HOP_SIZE;
+    const std::vector<float> signal = makeSignal((size_t)BENCH_SAMPLE_RATE);
+
+    // Кольцо истории в произвольном положении: развёртка идёт двумя кусками
+    std::vector<float> history(signal.begin(), signal.begin() + N);
+    std::vector<float> input(N);
+    std::vector<float> spectrum(2 * (N / 2 + 1));
+    const int historyPos = N / 3;
+    const float *w = windowTable<N>(WindowType::Hann).coeffs.data();
+
+    report("window", N, 0, hop, measure([&]
+                                        {
+        const int tailLen = N - historyPos;
+        for (int j = 0; j < tailLen; j++)
+            input[j] = history[historyPos + j] * w[j];
+        for (int j = tailLen; j < N; j++)
+            input[j] = history[j - tailLen] * w[j];
+        benchSink = input[N / 2]; },
+                                        iterations));
+
+    // Каждая реализация FFT отдельной строкой; спектр для следующих стадий
+    // остаётся от последней, от реализации он не зависит
+    const FftBackendType backends[] = {FftBackendType::Kiss, FftBackendType::Radix4, FftBackendType::SplitRadix};
+    const char *backendStages[] = {"fft-kiss", "fft-radix4", "fft-split-radix"};
+    for (int b = 0; b < 3; b++)
+    {
+        if (!fftBackendAvailable(backends[b]))
+            continue;
+        std::unique_ptr<FftBackend> fft = makeFftBackend(backends[b], N);
+        report(backendStages[b], N, 0, hop, measure([&]
+                                                    { fft->forward(input.data(), spectrum.data());
+                                                      benchSink = spectrum[2]; },
+                                                    iterations));
+    }
+
+    const BandPeakKernel kernel = bandPeakKernel(detectSimdLevel());
+    for (int bandCount : bandCounts)
+    {
+        const std::vector<BandData> bands = logBands(bandCount);
+        std::vector<BandRange> ranges;
+        buildBandRanges(bands, BENCH_SAMPLE_RATE, N, ranges);
+        float peaks[MAX_BANDS];
+        uint8_t levels[MAX_BANDS];
+        uint8_t packet[MAX_PACKET_SIZE];
+        // Полные кадры: при неизменных яркостях дельта свелась бы к одному заголовку
+        ProtocolEncoder encoder;
+        protocolEncoderInit(&encoder, 0, 0);
+
+        report("bands", N, bandCount, hop, measure([&]
+                                                   { kernel(spectrum.data(), ranges.data(), bands.size(), peaks);
+                                                     benchSink = peaks[0]; },
+                                                   iterations));
+
+        report("db", N, bandCount, hop, measure([&]
+                                                {
+            for (int b = 0; b < bandCount; b++)
+                levels[b] = bandLevel(sqrtf(peaks[b]) * (1.0f / (N / 2.0f)));
+            benchSink = levels[0]; },
+                                                iterations));
+
+        report("packet", N, bandCount, hop, measure([&]
+                                                    { benchSink = (float)encodeLevelsPacket(&encoder, levels, bandCount, packet) + packet[1]; },
+                                                    iterations));
+
+        // Весь конвейер движка: hop новых сэмплов дают ровно один кадр
+        AudioDSP<N> engine;
+        engine.setBands(bands);
+        engine.setHopSize(hop);
+        LastFrameSink sink;
+        size_t offset = 0;
+        report("frame", N, bandCount, hop, measure([&]
+                                                   {
+            if (offset + hop > signal.size())
+                offset = 0;
+            engine.process(signal.data() + offset, hop, sink);
+            offset += hop; },
+                                                   iterations));
+    }
+}
+
+static void benchSuite(int baseIterations)
+{
+    const std::vector<int> bandCounts = {6, 12, 24, MAX_BANDS};
+
+    printf("\n%-15s %6s %5s %12s %14s %12s\n", "stage", "fft", "bands", "ns/frame", "frames/s", "cycles/sample");
+    benchFftSize<256>(baseIterations, bandCounts);
+    benchFftSize<512>(baseIterations, bandCounts);
+    benchFftSize<1024>(baseIterations, bandCounts);
+    benchFftSize<2048>(baseIterations, bandCounts);
+    benchFftSize<4096>(baseIterations, bandCounts);
+    benchFftSize<8192>(baseIterations, bandCounts);
+    benchFftSize<16384>(baseIterations, bandCounts);
+
+    // То, что выберет --fft-backend auto на этом процессоре
+    printf("\nfastest FFT backend:");
+    for (int n = MIN_FFT_SIZE; n <= MAX_FFT_SIZE; n *= 2)
+        printf(" %d=%s", n, makeFftBackend(FftBackendType::Auto, n)->name());
+    printf("\n");
+}
+
+// Яркости из CSV пакетного режима: кадр на строку, первые два столбца — номер и время
+static bool readLevelsCsv(const char *path, std::vector<std::vector<uint8_t>> &frames)
+{
+    FILE *file = fopen(path, "r");
+    if (!file)
+        return false;
+
+    char line[4096];
+    if (!fgets(line, sizeof(line), file))
+    {
+        fclose(file);
+        return false;
+    }
+    while (fgets(line, sizeof(line), file))
+    {
+        std::vector<uint8_t> frame;
+        char *field = strchr(line, ',');
+        field = field ? strchr(field + 1, ',') : nullptr;
+        while (field)
+        {
+            frame.push_back((uint8_t)strtol(field + 1, nullptr, 10));
+            field = strchr(field + 1, ',');
+        }
+        if (frame.empty() || frame.size() > PROTOCOL_MAX_CHANNELS)
+        {
+            fclose(file);
+            return false;
+        }
+        frames.push_back(frame);
+    }
+    fclose(file);
+    return true;
+}
+
+static int benchEncodings(const std::vector<const char *> &paths)
+{
+    const struct
+    {
+        const char *name;
+        uint8_t format;
+    } formats[] = {{"raw", 0}, {"nibble", PROTOCOL_NIBBLE}, {"delta", PROTOCOL_DELTA}, {"delta-nibble", PROTOCOL_DELTA | PROTOCOL_NIBBLE}};
+
+    // 8N1: 10 бит на байт
+    const double bytesPerSecond = BAUD_RATE / 10.0;
+    printf("keyframe every %d frames, %d baud\n", DEFAULT_KEYFRAME_INTERVAL, BAUD_RATE);
+    printf("%-24s %-13s %8s %8s %10s %12s\n", "file", "encoding", "frames", "bands", "B/frame", "max frames/s");
+
+    for (const char *path : paths)
+    {
+        std::vector<std::vector<uint8_t>> frames;
+        if (!readLevelsCsv(path, frames) || frames.empty())
+        {
+            fprintf(stderr, "Error: cannot read levels from %s\n", path);
+            return 1;
+        }
+
+        const char *name = strrchr(path, '/');
+        name = name ? name + 1 : path;
+        for (const auto &format : formats)
+        {
+            ProtocolEncoder encoder;
+            protocolEncoderInit(&encoder, format.format, DEFAULT_KEYFRAME_INTERVAL);
+            uint8_t packet[MAX_PACKET_SIZE];
+            size_t bytes = 0;
+            for (const auto &frame : frames)
+                bytes += encodeLevelsPacket(&encoder, frame.data(), frame.size(), packet);
+
+            const double perFrame = (double)bytes / frames.size();
+            printf("%-24.24s %-13s %8zu %8zu %10.2f %12.0f\n", name, format.name, frames.size(), frames[0].size(),
+                   perFrame, bytesPerSecond / perFrame);
+        }
+    }
+    return 0;
+}
+
+static bool writeJson(const char *path, int iterations)
+{
+    FILE *file = fopen(path, "w");
+    if (!file)
+        return false;
+
+    fprintf(file, "{\n  \"simd\": \"%s\",\n  \"iterations\": %d,\n  \"sample_rate\": %.0f,\n  \"results\": [\n",
+            simdLevelName(detectSimdLevel()), iterations, BENCH_SAMPLE_RATE);
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const BenchResult &r = results[i];
+        fprintf(file, "    {\"stage\": \"%s\", \"fft\": %d, \"bands\": %d, \"hop\": %d, "
+                      "\"ns_per_frame\": %.2f, \"frames_per_s\": %.0f, \"cycles_per_sample\": %.4f}%s\n",
+                r.stage, r.fftSize, r.bands, r.hop, r.timing.ns, 1e9 / r.timing.ns,
+                r.timing.cycles / r.hop, i + 1 < results.size() ? "," : "");
+    }
+    fputs("  ]\n}\n", file);
+    fclose(file);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = BENCH_DEFAULT_ITERATIONS;
+    const char *jsonPath = nullptr;
+    std::vector<const char *> levelFiles;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+            jsonPath = argv[++i];
+        else if (strcmp(argv[i], "--levels") == 0)
+        {
+            while (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0)
+                levelFiles.push_back(argv[++i]);
+        }
+        else
+            iterations = atoi(argv[i]);
+    }
+
+    if (!levelFiles.empty())
+        return benchEncodings(levelFiles);
+
+    std::vector<BandData> bands = defaultBands();
+    std::vector<BandRange> ranges;
+    buildBandRanges(bands, BENCH_SAMPLE_RATE, BENCH_FFT_SIZE, ranges);
+
+    std::vector<float> spectrum(2 * (BENCH_FFT_SIZE / 2 + 1));
+    srand(1);
+    for (float &v : spectrum)
+        v = (float)rand() / RAND_MAX * 2.0f - 1.0f;
+
+    std::vector<float> reference(bands.size());
+    std::vector<float> peaks(bands.size());
+
+    const double legacyNs = measure([&]
+                                      { legacyBandMax(spectrum.data(), bands, reference.data());
+                                        benchSink = reference[0]; },
+                                      iterations)
+                                  .ns;
+    printf("FFT %d, %zu bands, detected %s\n", BENCH_FFT_SIZE, bands.size(), simdLevelName(detectSimdLevel()));
+    printf("%-10s %10.1f ns/frame\n", "legacy", legacyNs);
+
+    const SimdLevel levels[] = {SimdLevel::Scalar, SimdLevel::Sse2, SimdLevel::Avx2, SimdLevel::Avx512};
+    for (SimdLevel level : levels)
+    {
+        if (level > detectSimdLevel())
+            break;
+
+        BandPeakKernel kernel = bandPeakKernel(level);
+        const double ns = measure([&]
+                                    { kernel(spectrum.data(), ranges.data(), bands.size(), peaks.data());
+                                      for (size_t b = 0; b < bands.size(); b++)
+                                          peaks[b] = sqrtf(peaks[b]) / (BENCH_FFT_SIZE / 2.0f);
+                                      benchSink = peaks[0]; },
+                                    iterations)
+                                .ns;
+
+        // Сверка с прежним циклом
+        float maxError = 0.0f;
+        for (size_t b = 0; b < bands.size(); b++)
+            maxError = fmaxf(maxError, fabsf(peaks[b] - reference[b]));
+
+        printf("%-10s %10.1f ns/frame  x%.1f  max error %g\n", simdLevelName(level), ns, legacyNs / ns, maxError);
+    }
+
+    enableFlushToZero();
+    benchSuite(iterations);
+    benchEngines(bands);
+
+    if (jsonPath)
+    {
+        if (!writeJson(jsonPath, iterations))
+        {
+            fprintf(stderr, "Error: cannot write %s\n", jsonPath);
+            return 1;
+        }
+        printf("\n%zu results written to %s\n", results.size(), jsonPath);
+    }
+    return 0;
+}
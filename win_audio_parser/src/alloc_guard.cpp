@@ -0,0 +1,88 @@
+#include "alloc_guard.h"
+
+#ifdef AUDIO_ALLOC_GUARD
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+static thread_local bool allocGuardArmed = false;
+
+void allocGuardArm()
+{
+    allocGuardArmed = true;
+}
+
+void allocGuardDisarm()
+{
+    allocGuardArmed = false;
+}
+
+static void checkAllocation(size_t size)
+{
+    if (!allocGuardArmed)
+        return;
+
+    // Дальше только функции без выделения памяти
+    allocGuardArmed = false;
+    fprintf(stderr, "\nAllocation of %zu bytes on a real-time thread\n", size);
+    abort();
+}
+
+static void *allocate(size_t size)
+{
+    checkAllocation(size);
+    void *p = malloc(size ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+static void *allocateAligned(size_t size, std::align_val_t align)
+{
+    checkAllocation(size);
+    const size_t alignment = (size_t)align;
+#if defined(_MSC_VER) || defined(__MINGW32__)
+    void *p = _aligned_malloc(size ? size : 1, alignment);
+#else
+    // aligned_alloc требует размер, кратный выравниванию
+    void *p = aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+static void freeAligned(void *p)
+{
+#if defined(_MSC_VER) || defined(__MINGW32__)
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
+
+void *operator new(size_t size) { return allocate(size); }
+void *operator new[](size_t size) { return allocate(size); }
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    checkAllocation(size);
+    return malloc(size ? size : 1);
+}
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    checkAllocation(size);
+    return malloc(size ? size : 1);
+}
+void *operator new(size_t size, std::align_val_t align) { return allocateAligned(size, align); }
+void *operator new[](size_t size, std::align_val_t align) { return allocateAligned(size, align); }
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete(void *p, size_t, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete[](void *p, size_t, std::align_val_t) noexcept { freeAligned(p); }
+
+#endif
@@ -0,0 +1,12 @@
+// Отладочная проверка: после запуска аудио- и DSP-потоки не должны выделять память.
+// Включается опцией CMake AUDIO_ALLOC_GUARD, в обычной сборке функции пустые.
+#pragma once
+
+#ifdef AUDIO_ALLOC_GUARD
+// С этого момента любой operator new в текущем потоке завершает программу
+void allocGuardArm();
+void allocGuardDisarm();
+#else
+inline void allocGuardArm() {}
+inline void allocGuardDisarm() {}
+#endif
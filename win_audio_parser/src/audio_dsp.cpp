@@ -0,0 +1,32 @@
+#include "audio_dsp.h"
+
+template struct AudioDSP<256>;
+template struct AudioDSP<512>;
+template struct AudioDSP<1024>;
+template struct AudioDSP<2048>;
+template struct AudioDSP<4096>;
+template struct AudioDSP<8192>;
+template struct AudioDSP<16384>;
+
+std::unique_ptr<BandEngine> makeFftEngine(int fftSize)
+{
+    switch (fftSize)
+    {
+    case 256:
+        return std::unique_ptr<BandEngine>(new AudioDSP<256>());
+    case 512:
+        return std::unique_ptr<BandEngine>(new AudioDSP<512>());
+    case 1024:
+        return std::unique_ptr<BandEngine>(new AudioDSP<1024>());
+    case 2048:
+        return std::unique_ptr<BandEngine>(new AudioDSP<2048>());
+    case 4096:
+        return std::unique_ptr<BandEngine>(new AudioDSP<4096>());
+    case 8192:
+        return std::unique_ptr<BandEngine>(new AudioDSP<8192>());
+    case 16384:
+        return std::unique_ptr<BandEngine>(new AudioDSP<16384>());
+    default:
+        return nullptr;
+    }
+}
@@ -0,0 +1,148 @@
+// Конвейер анализа на FFT: скользящее окно -> FFT (см. fft_backend.h) -> пики полос -> яркости.
+// Размер FFT — параметр шаблона: массивы фиксированные, нормировка сворачивается в константу.
+#pragma once
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "band_engine.h"
+#include "band_map.h"
+#include "fft_backend.h"
+#include "latency_stats.h"
+#include "spectrum_kernels.h"
+#include "window_tables.h"
+
+#define DEFAULT_FFT_SIZE 4096 // Размер окна (степень двойки)
+#define MIN_FFT_SIZE 256
+#define MAX_FFT_SIZE 16384
+#define DEFAULT_HOP_SIZE 512 // Шаг между кадрами: 512 сэмплов = ~86 кадров/с при 44.1 кГц
+
+template <int N>
+struct AudioDSP : BandEngine
+{
+    static_assert(N >= MIN_FFT_SIZE && N <= MAX_FFT_SIZE && (N & (N - 1)) == 0, "FFT size must be a power of two");
+
+    static constexpr int BIN_COUNT = N / 2 + 1;
+    static constexpr float MAGNITUDE_NORM = 1.0f / (N / 2.0f);
+
+    std::vector<BandData> bands;
+    std::vector<BandRange> bandRanges; // Бины каждой полосы, см. rebuildBandRanges
+    std::unique_ptr<FftBackend> fft = makeFftBackend(defaultFftBackend(), N);
+    float history[N]; // Последние N сэмплов (кольцо), окно скользит по ним
+    int historyPos = 0; // Куда писать следующий сэмпл; он же самый старый сэмпл окна
+    float fftInput[N];
+    float fftOutput[2 * BIN_COUNT]; // Пары (re, im)
+    int hop = N < DEFAULT_HOP_SIZE ? N : DEFAULT_HOP_SIZE;
+    int hopCounter = 0; // Сэмплов с момента предыдущего кадра
+    float rate = 44100.0f;
+    const WindowTable<N> *window = &windowTable<N>(WindowType::Hann);
+    BandPeakKernel bandPeaks = bandPeakKernel(detectSimdLevel());
+    float magnitudeScale = window->gainToHann * MAGNITUDE_NORM;
+
+    // Рабочие буферы кадра заведены заранее: в горячем пути нет ни одного new
+    float bandPeak[MAX_BANDS];
+    uint8_t levels[MAX_BANDS];
+
+    AudioDSP()
+    {
+        memset(history, 0, sizeof(history));
+        memset(fftInput, 0, sizeof(fftInput));
+    }
+
+    AudioDSP(const AudioDSP &) = delete;
+    AudioDSP &operator=(const AudioDSP &) = delete;
+
+    // Шаг можно менять на лету: перекрытие окон = N - hop
+    bool setHopSize(int newHop) override
+    {
+        if (newHop < 1 || newHop > N)
+            return false;
+        hop = newHop;
+        hopCounter = 0;
+        return true;
+    }
+
+    bool setBands(const std::vector<BandData> &newBands) override
+    {
+        if (newBands.size() > MAX_BANDS)
+            return false;
+        bands = newBands;
+        rebuildBandRanges();
+        return true;
+    }
+
+    void setSampleRate(float newRate) override
+    {
+        rate = newRate;
+        rebuildBandRanges();
+    }
+
+    void rebuildBandRanges()
+    {
+        buildBandRanges(bands, rate, N, bandRanges);
+    }
+
+    void setWindow(WindowType type) override
+    {
+        window = &windowTable<N>(type);
+        magnitudeScale = window->gainToHann * MAGNITUDE_NORM;
+    }
+
+    int fftSize() const override { return N; }
+    int hopSize() const override { return hop; }
+    float sampleRate() const override { return rate; }
+    std::string backendName() const override { return fft->name(); }
+
+    void process(const float *samples, size_t count, FrameSink &sink) override
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            history[historyPos] = samples[i];
+            historyPos = (historyPos + 1) & (N - 1);
+            hopCounter++;
+
+            if (hopCounter >= hop)
+            {
+                analyzeFrame();
+                sink.onFrame(levels, bands.size());
+                hopCounter = 0;
+            }
+        }
+    }
+
+    void analyzeFrame()
+    {
+        // 1. Разворачиваем кольцо истории (от старого сэмпла к новому) и сразу
+        // умножаем на окно (убирает шумы на соседних каналах)
+        const float *w = window->coeffs.data();
+        const int tailLen = N - historyPos;
+        for (int j = 0; j < tailLen; j++)
+            fftInput[j] = history[historyPos + j] * w[j];
+        for (int j = tailLen; j < N; j++)
+            fftInput[j] = history[j - tailLen] * w[j];
+        latencyMark(LatencyStage::Window);
+
+        fft->forward(fftInput, fftOutput);
+        latencyMark(LatencyStage::Fft);
+
+        // Векторное ядро отдаёт квадрат пиковой амплитуды по каждой полосе,
+        // корень и логарифм берём уже один раз на полосу
+        bandPeaks(fftOutput, bandRanges.data(), bands.size(), bandPeak);
+        for (size_t b = 0; b < bands.size(); b++)
+            levels[b] = bandLevel(sqrtf(bandPeak[b]) * magnitudeScale);
+        latencyMark(LatencyStage::Bands);
+    }
+};
+
+// Каждый размер собирается один раз в audio_dsp.cpp
+extern template struct AudioDSP<256>;
+extern template struct AudioDSP<512>;
+extern template struct AudioDSP<1024>;
+extern template struct AudioDSP<2048>;
+extern template struct AudioDSP<4096>;
+extern template struct AudioDSP<8192>;
+extern template struct AudioDSP<16384>;
+
+// Выбор готовой специализации по размеру из командной строки; nullptr для
+// неподдерживаемых размеров
+std::unique_ptr<BandEngine> makeFftEngine(int fftSize);
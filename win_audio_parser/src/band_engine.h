@@ -0,0 +1,36 @@
+// Общий интерфейс движков, превращающих поток сэмплов в яркости полос
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "band_map.h"
+#include "window_tables.h"
+
+// Получатель готовых кадров: levels[count] — яркости полос 0..255
+struct FrameSink
+{
+    virtual ~FrameSink() = default;
+    virtual void onFrame(const uint8_t *levels, size_t count) = 0;
+};
+
+struct BandEngine
+{
+    virtual ~BandEngine() = default;
+
+    virtual bool setBands(const std::vector<BandData> &bands) = 0;
+    // Пересчитывает все частотные таблицы под новую частоту дискретизации
+    virtual void setSampleRate(float rate) = 0;
+    // Кадр выдаётся каждые hop сэмплов
+    virtual bool setHopSize(int hop) = 0;
+    virtual void setWindow(WindowType type) = 0;
+
+    virtual int fftSize() const = 0;
+    virtual int hopSize() const = 0;
+    virtual float sampleRate() const = 0;
+    // Какими реализациями FFT движок считает на самом деле (FftBackend::name)
+    virtual std::string backendName() const = 0;
+
+    // Вызывается только из потока анализа; sink может сработать несколько раз за вызов
+    virtual void process(const float *samples, size_t count, FrameSink &sink) = 0;
+};
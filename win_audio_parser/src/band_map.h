@@ -0,0 +1,78 @@
+// Полосы частот и их привязка к бинам FFT
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Предел числа полос: под него заранее выделены буферы кадра
+#define MAX_BANDS 32
+
+struct BandData
+{
+    float freqMin;
+    float freqMax;
+    float multiplier; // Теперь работает как коэффициент чувствительности в дБ
+};
+
+// Полоса в виде непрерывного диапазона бинов [firstBin, lastBin)
+struct BandRange
+{
+    int firstBin;
+    int lastBin;
+};
+
+// Первый бин, частота которого >= freq (частота бина = bin * binHz)
+inline int firstBinAtOrAbove(float freq, float binHz, int binCount)
+{
+    int bin = (int)ceilf(freq / binHz);
+    if (bin < 0)
+        bin = 0;
+    // ceilf по частному может ошибиться на единицу из-за округления
+    while (bin > 0 && (bin - 1) * binHz >= freq)
+        bin--;
+    while (bin < binCount && bin * binHz < freq)
+        bin++;
+    return bin > binCount ? binCount : bin;
+}
+
+// Пересчитывается при смене полос, частоты дискретизации или размера FFT,
+// чтобы на каждом кадре не сравнивать каждый бин с каждой полосой
+inline void buildBandRanges(const std::vector<BandData> &bands, float sampleRate, int fftSize,
+                            std::vector<BandRange> &ranges)
+{
+    const int binCount = fftSize / 2 + 1;
+    const float binHz = sampleRate / (float)fftSize;
+
+    ranges.resize(bands.size());
+    for (size_t b = 0; b < bands.size(); b++)
+    {
+        ranges[b].firstBin = firstBinAtOrAbove(bands[b].freqMin, binHz, binCount);
+        ranges[b].lastBin = firstBinAtOrAbove(bands[b].freqMax, binHz, binCount);
+        if (ranges[b].lastBin < ranges[b].firstBin)
+            ranges[b].lastBin = ranges[b].firstBin;
+    }
+}
+
+// Логарифмическая обработка (дБ): нормализованная амплитуда -> яркость 0..255
+inline uint8_t bandLevel(float magnitude)
+{
+    // Перевод в децибелы (magnitude 1.0 = 0dB, 0.01 = -40dB)
+    float db = 20.0f * log10f(magnitude + 1e-6f);
+
+    // Настройки диапазона:
+    // minDb - уровень полной темноты (шум покоя)
+    // maxDb - уровень максимальной яркости (пик)
+    float minDb = -50.0f;
+    float maxDb = 0.0f;
+    // float maxDb = -15.0f / band.multiplier;
+
+    // Линейная интерполяция дБ в диапазон 0..1
+    float normalized = (db - minDb) / (maxDb - minDb);
+
+    if (normalized < 0.0f)
+        normalized = 0.0f;
+    if (normalized > 1.0f)
+        normalized = 1.0f;
+
+    return (uint8_t)(normalized * 255.0f);
+}
@@ -0,0 +1,307 @@
+#include "batch_analysis.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include "miniaudio.h"
+#include "work_stealing_pool.h"
+
+// Результат одного файла. Куски пишут каждый в свой диапазон кадров,
+// поэтому общий буфер не требует блокировок.
+struct FileJob
+{
+    std::string input;
+    std::string output;
+    ma_uint64 totalFrames = 0; // 0 — длина неизвестна, файл идёт одним куском
+    ma_uint32 sampleRate = 0;
+    int analysisChannels = 1;
+    int hop = 0;
+    size_t bandsPerFrame = 0;
+    std::vector<uint8_t> levels; // [кадр][канал * полосы + полоса]
+    std::atomic<int> chunksLeft{0};
+    std::atomic<bool> failed{false};
+};
+
+// Общее состояние прогона
+struct BatchRun
+{
+    const BatchOptions *batch;
+    const EngineOptions *engine;
+    const std::vector<BandData> *bands;
+    WorkStealingPool *pool;
+    std::atomic<int> filesDone{0};
+    std::atomic<int> filesFailed{0};
+    std::atomic<unsigned long long> framesDecoded{0};
+    std::atomic<unsigned long long> secondsMilli{0}; // Длительность обработанного звука, мс
+};
+
+// Кадры одного канала внутри куска: всё, что до firstFrame, — разгон истории
+struct ChunkSink : FrameSink
+{
+    FileJob *job;
+    int channel;
+    size_t frameIndex;
+    size_t firstFrame;
+    size_t endFrame;
+
+    void onFrame(const uint8_t *levels, size_t count) override
+    {
+        const size_t index = frameIndex++;
+        if (index < firstFrame || index >= endFrame)
+            return;
+        // Длина неизвестна — кусок единственный, буфер растёт по мере чтения
+        if ((index + 1) * job->bandsPerFrame > job->levels.size())
+            job->levels.resize((index + 1) * job->bandsPerFrame);
+        memcpy(job->levels.data() + index * job->bandsPerFrame + channel * count, levels, count);
+    }
+};
+
+static bool openDecoder(const std::string &path, ma_decoder *decoder)
+{
+    // Родные частота и раскладка: ресемплер декодера не нужен, сводим сами
+    ma_decoder_config config = ma_decoder_config_init(ma_format_f32, 0, 0);
+    return ma_decoder_init_file(path.c_str(), &config, decoder) == MA_SUCCESS;
+}
+
+// Сколько сэмплов нужно прогнать перед куском, чтобы история движка совпала
+// со сплошным проходом: окно FFT, а для прореживания — окно на пониженной частоте
+static ma_uint64 warmupFrames(const EngineOptions &engine, int hop)
+{
+    ma_uint64 frames = (ma_uint64)engine.fftSize * 2;
+    if (engine.multiResolution)
+        frames *= engine.decimation;
+    return (frames + hop - 1) / hop * hop;
+}
+
+static void writeCsv(const FileJob &job)
+{
+    FILE *file = fopen(job.output.c_str(), "w");
+    if (!file)
+    {
+        fprintf(stderr, "Error: cannot write %s\n", job.output.c_str());
+        return;
+    }
+
+    const size_t bands = job.bandsPerFrame / job.analysisChannels;
+    fputs("frame,time_s", file);
+    for (int c = 0; c < job.analysisChannels; c++)
+    {
+        for (size_t b = 0; b < bands; b++)
+        {
+            if (job.analysisChannels > 1)
+                fprintf(file, ",ch%d_band%zu", c + 1, b + 1);
+            else
+                fprintf(file, ",band%zu", b + 1);
+        }
+    }
+    fputc('\n', file);
+
+    const size_t frames = job.levels.size() / job.bandsPerFrame;
+    for (size_t f = 0; f < frames; f++)
+    {
+        // Кадр выдаётся по окончании своего шага
+        fprintf(file, "%zu,%.4f", f, (double)(f + 1) * job.hop / job.sampleRate);
+        const uint8_t *row = job.levels.data() + f * job.bandsPerFrame;
+        for (size_t b = 0; b < job.bandsPerFrame; b++)
+            fprintf(file, ",%d", (int)row[b]);
+        fputc('\n', file);
+    }
+    fclose(file);
+}
+
+static void finishChunk(BatchRun *run, FileJob *job)
+{
+    if (--job->chunksLeft > 0)
+        return;
+
+    if (job->failed)
+    {
+        run->filesFailed++;
+        return;
+    }
+    writeCsv(*job);
+    run->filesDone++;
+    const size_t frames = job->levels.size() / job->bandsPerFrame;
+    run->secondsMilli += (unsigned long long)((double)frames * job->hop * 1000.0 / job->sampleRate);
+}
+
+// Анализ кадров [startFrame, endFrame) файла с разгоном на предыдущих сэмплах
+static void analyzeChunk(BatchRun *run, FileJob *job, ma_uint64 startFrame, ma_uint64 endFrame)
+{
+    ma_decoder decoder;
+    if (!openDecoder(job->input, &decoder))
+    {
+        job->failed = true;
+        finishChunk(run, job);
+        return;
+    }
+
+    const int channels = (int)decoder.outputChannels;
+    const int analysisChannels = job->analysisChannels;
+    std::vector<std::unique_ptr<BandEngine>> engines;
+    for (int c = 0; c < analysisChannels; c++)
+    {
+        engines.push_back(makeEngine(*run->engine));
+        engines.back()->setBands(*run->bands);
+        engines.back()->setSampleRate((float)job->sampleRate);
+    }
+
+    const ma_uint64 warmup = std::min(startFrame, warmupFrames(*run->engine, job->hop));
+    const ma_uint64 decodeFrom = startFrame - warmup;
+    if (decodeFrom > 0 && ma_decoder_seek_to_pcm_frame(&decoder, decodeFrom) != MA_SUCCESS)
+    {
+        ma_decoder_uninit(&decoder);
+        job->failed = true;
+        finishChunk(run, job);
+        return;
+    }
+
+    // Граница куска кратна шагу, так что номера кадров совпадают со сплошным проходом
+    std::vector<ChunkSink> sinks(analysisChannels);
+    for (int c = 0; c < analysisChannels; c++)
+    {
+        sinks[c].job = job;
+        sinks[c].channel = c;
+        sinks[c].frameIndex = (size_t)(decodeFrom / job->hop);
+        sinks[c].firstFrame = (size_t)(startFrame / job->hop);
+        sinks[c].endFrame = job->totalFrames ? (size_t)(endFrame / job->hop) : (size_t)-1;
+    }
+
+    const SimdLevel simd = detectSimdLevel();
+    const DownmixKernel downmix = downmixKernel(run->batch->downmix, simd);
+    const DeinterleaveKernel deinterleave = deinterleaveKernel(simd);
+
+    std::vector<float> interleaved((size_t)BATCH_READ_FRAMES * channels);
+    std::vector<float> planar((size_t)BATCH_READ_FRAMES * analysisChannels);
+    float *outs[MAX_CAPTURE_CHANNELS];
+    for (int c = 0; c < analysisChannels; c++)
+        outs[c] = planar.data() + (size_t)c * BATCH_READ_FRAMES;
+
+    ma_uint64 position = decodeFrom;
+    while (position < endFrame)
+    {
+        const ma_uint64 want = std::min<ma_uint64>(BATCH_READ_FRAMES, endFrame - position);
+        ma_uint64 got = 0;
+        ma_decoder_read_pcm_frames(&decoder, interleaved.data(), want, &got);
+        if (got == 0)
+            break;
+
+        if (run->batch->downmix == DownmixMode::Split)
+            deinterleave(interleaved.data(), (size_t)got, channels, outs, analysisChannels);
+        else
+            downmix(interleaved.data(), (size_t)got, channels, outs[0]);
+
+        for (int c = 0; c < analysisChannels; c++)
+            engines[c]->process(outs[c], (size_t)got, sinks[c]);
+
+        position += got;
+        run->framesDecoded += got;
+    }
+
+    ma_decoder_uninit(&decoder);
+    finishChunk(run, job);
+}
+
+// Первая задача файла: узнаёт формат и длину и ставит задачи на куски
+static void planFile(BatchRun *run, FileJob *job)
+{
+    ma_decoder decoder;
+    if (!openDecoder(job->input, &decoder))
+    {
+        fprintf(stderr, "Error: cannot decode %s\n", job->input.c_str());
+        run->filesFailed++;
+        return;
+    }
+
+    ma_uint64 length = 0;
+    if (ma_decoder_get_length_in_pcm_frames(&decoder, &length) != MA_SUCCESS)
+        length = 0;
+    job->totalFrames = length;
+    job->sampleRate = decoder.outputSampleRate;
+    const int channels = (int)decoder.outputChannels;
+    ma_decoder_uninit(&decoder);
+
+    const size_t bandCount = run->bands->size();
+    job->analysisChannels = 1;
+    if (run->batch->downmix == DownmixMode::Split)
+        job->analysisChannels = std::min(std::min(channels, MAX_CAPTURE_CHANNELS), (int)(MAX_BANDS / bandCount));
+    job->bandsPerFrame = bandCount * job->analysisChannels;
+
+    std::unique_ptr<BandEngine> probe = makeEngine(*run->engine);
+    probe->setSampleRate((float)job->sampleRate);
+    job->hop = probe->hopSize();
+
+    if (length == 0)
+    {
+        job->chunksLeft = 1;
+        run->pool->submit([run, job]
+                          { analyzeChunk(run, job, 0, (ma_uint64)-1); });
+        return;
+    }
+
+    job->levels.assign((size_t)(length / job->hop) * job->bandsPerFrame, 0);
+
+    // Кусок — целое число шагов, последний забирает остаток
+    const ma_uint64 chunkSteps = std::max<ma_uint64>(1, (ma_uint64)BATCH_CHUNK_SECONDS * job->sampleRate / job->hop);
+    const ma_uint64 chunkFrames = chunkSteps * job->hop;
+    const int chunks = (int)((length + chunkFrames - 1) / chunkFrames);
+    job->chunksLeft = chunks;
+    for (int i = 0; i < chunks; i++)
+    {
+        const ma_uint64 start = (ma_uint64)i * chunkFrames;
+        const ma_uint64 end = std::min(length, start + chunkFrames);
+        run->pool->submit([run, job, start, end]
+                          { analyzeChunk(run, job, start, end); });
+    }
+}
+
+static std::string outputPath(const std::string &input, const std::string &outDir)
+{
+    if (outDir.empty())
+        return input + ".bands.csv";
+
+    const size_t slash = input.find_last_of("/\\");
+    const std::string name = slash == std::string::npos ? input : input.substr(slash + 1);
+    const char last = outDir.back();
+    return outDir + (last == '/' || last == '\\' ? "" : "/") + name + ".bands.csv";
+}
+
+int runBatch(const BatchOptions &batch, const EngineOptions &engine, const std::vector<BandData> &bands)
+{
+    // Параметры проверяются один раз здесь, а не в каждой задаче
+    if (!makeEngine(engine))
+        return (int)batch.files.size();
+
+    std::vector<std::unique_ptr<FileJob>> jobs;
+    for (const std::string &file : batch.files)
+    {
+        jobs.emplace_back(new FileJob());
+        jobs.back()->input = file;
+        jobs.back()->output = outputPath(file, batch.outDir);
+    }
+
+    WorkStealingPool pool(batch.threads);
+    BatchRun run;
+    run.batch = &batch;
+    run.engine = &engine;
+    run.bands = &bands;
+    run.pool = &pool;
+
+    const auto started = std::chrono::steady_clock::now();
+    for (auto &job : jobs)
+    {
+        FileJob *fileJob = job.get();
+        pool.submit([&run, fileJob]
+                    { planFile(&run, fileJob); });
+    }
+    pool.wait();
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    const double audioSeconds = run.secondsMilli / 1000.0;
+    printf("%d files (%d failed), %.1f s of audio in %.2f s on %d threads: %.2f files/s, %.1fx real time, %.1f Mframes/s\n",
+           run.filesDone.load(), run.filesFailed.load(), audioSeconds, elapsed, pool.threadCount(),
+           run.filesDone / elapsed, audioSeconds / elapsed, run.framesDecoded / elapsed / 1e6);
+    return run.filesFailed;
+}
@@ -0,0 +1,26 @@
+// Пакетный анализ файлов быстрее реального времени: тот же движок полос, что
+// и для захвата, но источник — декодер miniaudio (WAV, FLAC, MP3). Файлы и
+// куски длинных файлов разбирает пул потоков с кражей задач.
+#pragma once
+#include <string>
+#include <vector>
+#include "band_map.h"
+#include "downmix.h"
+#include "engine_options.h"
+
+// Длинный файл режется на куски такой длительности, чтобы занять все ядра
+#define BATCH_CHUNK_SECONDS 30
+// Кадров декодера за одно чтение
+#define BATCH_READ_FRAMES 4096
+
+struct BatchOptions
+{
+    std::vector<std::string> files;
+    std::string outDir; // Пусто — CSV кладётся рядом с исходным файлом
+    int threads = 0;    // 0 — по числу логических ядер
+    DownmixMode downmix = DownmixMode::Mid;
+};
+
+// Для каждого файла пишет <имя>.bands.csv: номер кадра, время и яркости полос.
+// Возвращает число файлов, которые не удалось обработать.
+int runBatch(const BatchOptions &batch, const EngineOptions &engine, const std::vector<BandData> &bands);
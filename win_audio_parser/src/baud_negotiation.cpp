@@ -0,0 +1,88 @@
+#include "baud_negotiation.h"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include "board_control.h"
+
+static bool verifyPattern(SerialTransport &port, ProtocolDecoder &decoder)
+{
+    uint8_t reply[PROTOCOL_MAX_DATA];
+    uint8_t size = 0;
+    return boardRequest(port, decoder, PROTOCOL_CMD_VERIFY, PROTOCOL_VERIFY_PATTERN, PROTOCOL_VERIFY_SIZE, reply, &size) &&
+           size == PROTOCOL_VERIFY_SIZE && memcmp(reply, PROTOCOL_VERIFY_PATTERN, PROTOCOL_VERIFY_SIZE) == 0;
+}
+
+// true — порт и плата остались на baud; false — обе стороны снова на current
+static bool tryBaud(SerialTransport &port, ProtocolDecoder &decoder, int current, int baud)
+{
+    uint8_t args[4];
+    uint8_t reply[PROTOCOL_MAX_DATA];
+    uint8_t size = 0;
+    protocolPutU32(args, (uint32_t)baud);
+    // Без ответа плата либо не переключалась, либо уже вернулась по таймауту
+    if (!boardRequest(port, decoder, PROTOCOL_CMD_SET_BAUD, args, 4, reply, &size))
+        return false;
+    if (size != 4 || protocolGetU32(reply) != (uint32_t)baud)
+        return false;
+
+    // Плата переходит на новую скорость, как только допишет ответ
+    if (!port.setBaud(baud))
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(PROTOCOL_VERIFY_TIMEOUT_MS * 2));
+        port.setBaud(current);
+        return false;
+    }
+    protocolDecoderReset(&decoder);
+
+    bool verified = true;
+    for (int round = 0; round < NEGOTIATION_VERIFY_ROUNDS && verified; round++)
+        verified = verifyPattern(port, decoder);
+    if (verified && boardRequest(port, decoder, PROTOCOL_CMD_COMMIT, NULL, 0, reply, &size))
+        return true;
+
+    // Откат. Если COMMIT дошёл, а ответ нет, плата закрепилась и вернётся
+    // только по сторожевому таймауту линии — ждём его в любом случае
+    port.setBaud(current);
+    protocolDecoderReset(&decoder);
+    const int wait = verified ? PROTOCOL_LINK_TIMEOUT_MS : PROTOCOL_VERIFY_TIMEOUT_MS;
+    std::this_thread::sleep_for(std::chrono::milliseconds(wait + BOARD_REPLY_MS));
+    return false;
+}
+
+int negotiateBaud(SerialTransport &port, int baseBaud, int maxBaud)
+{
+    ProtocolDecoder decoder;
+    protocolDecoderInit(&decoder);
+
+    // Одиночный разделитель сбрасывает приёмник платы, если в нём застрял мусор
+    port.write(&PROTOCOL_DELIMITER, 1);
+
+    uint8_t reply[PROTOCOL_MAX_DATA];
+    uint8_t size = 0;
+    if (!boardRequest(port, decoder, PROTOCOL_CMD_HELLO, NULL, 0, reply, &size) || size < 4)
+    {
+        std::cout << "Board did not answer the handshake: staying at " << baseBaud << " baud" << std::endl;
+        return baseBaud;
+    }
+    const int boardMax = (int)protocolGetU32(reply);
+    // Прошивки до счётчиков приёма отвечают одной скоростью
+    if (size >= 8 && (protocolGetU16(reply + 4) != 0 || protocolGetU16(reply + 6) != 0))
+        std::cout << "Board receive errors since reset: " << protocolGetU16(reply + 4) << " USART overruns, "
+                  << protocolGetU16(reply + 6) << " bad frames" << std::endl;
+
+    const int candidates[] = {2000000, 1000000, 500000, 250000};
+    for (int baud : candidates)
+    {
+        if (baud > maxBaud || baud > boardMax || baud <= baseBaud)
+            continue;
+        if (tryBaud(port, decoder, baseBaud, baud))
+        {
+            std::cout << "Link negotiated at " << baud << " baud (board max " << boardMax << ")" << std::endl;
+            return baud;
+        }
+        std::cout << baud << " baud failed verification, falling back" << std::endl;
+    }
+    std::cout << "Link stays at " << baseBaud << " baud" << std::endl;
+    return baseBaud;
+}
@@ -0,0 +1,17 @@
+// Согласование скорости порта с прошивкой: HELLO, затем сверху вниз
+// SET_BAUD -> VERIFY -> COMMIT по протоколу из shared_protocol.h, запросами
+// из board_control.h.
+// Проверить без платы можно через board_sim (tools/board_sim.cpp) на pty.
+#pragma once
+#include "serial_transport.h"
+
+// Сколько проверок шаблоном должно пройти подряд, прежде чем закрепить скорость
+#define NEGOTIATION_VERIFY_ROUNDS 4
+// Потолок по умолчанию: USART Uno с U2X на 16 МГц
+#define NEGOTIATION_DEFAULT_MAX_BAUD 2000000
+
+// Порт открыт на baseBaud. Возвращает скорость, на которой порт остался:
+// наибольшую из проверенных не выше maxBaud или baseBaud, если плата не
+// отвечает (старая прошивка) или ни одна скорость не прошла проверку.
+int negotiateBaud(SerialTransport &port, int baseBaud, int maxBaud);
+
@@ -0,0 +1,56 @@
+#include "board_control.h"
+#include <chrono>
+#include <cstring>
+
+bool boardAwaitReply(SerialTransport &port, ProtocolDecoder &decoder, uint8_t command, uint8_t *args, uint8_t *size)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(BOARD_REPLY_MS);
+    uint8_t buffer[64];
+    for (;;)
+    {
+        const int left = (int)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+        if (left <= 0)
+            return false;
+        const int n = port.read(buffer, sizeof(buffer), left);
+        if (n < 0)
+            return false;
+        for (int i = 0; i < n; i++)
+        {
+            if (!protocolDecode(&decoder, buffer[i]) || protocolControlCommand(&decoder) != command)
+                continue;
+            *size = protocolControlArgsSize(&decoder);
+            memcpy(args, protocolControlArgs(&decoder), *size);
+            return true;
+        }
+    }
+}
+
+bool boardRequest(SerialTransport &port, ProtocolDecoder &decoder, uint8_t command, const uint8_t *args, uint8_t size,
+                  uint8_t *reply, uint8_t *replySize)
+{
+    uint8_t packet[PROTOCOL_MAX_FRAME];
+    const uint8_t length = protocolEncodeControl(command, args, size, packet);
+    for (int attempt = 0; attempt < BOARD_REQUEST_ATTEMPTS; attempt++)
+    {
+        if (port.write(packet, length) && boardAwaitReply(port, decoder, command, reply, replySize))
+            return true;
+    }
+    return false;
+}
+
+bool requestBrightnessCurve(SerialTransport &port, uint8_t curve)
+{
+    ProtocolDecoder decoder;
+    protocolDecoderInit(&decoder);
+    uint8_t reply[PROTOCOL_MAX_DATA];
+    uint8_t size = 0;
+    // В ответе — кривые всех каналов платы; каждая должна стать запрошенной
+    if (!boardRequest(port, decoder, PROTOCOL_CMD_SET_CURVE, &curve, 1, reply, &size) || size == 0)
+        return false;
+    for (uint8_t i = 0; i < size; i++)
+    {
+        if (reply[i] != curve)
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,26 @@
+// Управляющие кадры платы по схеме запрос-ответ из shared_protocol.h:
+// кадр с командой уходит с повторами, ответом считается первый управляющий
+// кадр с той же командой. На этом построены согласование скорости
+// (baud_negotiation.h) и настройки платы вроде кривой яркости.
+#pragma once
+#include <stdint.h>
+#include "serial_transport.h"
+#include "shared_protocol.h"
+
+// Сколько раз повторяется каждый запрос, прежде чем считать плату молчащей
+#define BOARD_REQUEST_ATTEMPTS 3
+// Ожидание ответа на один запрос
+#define BOARD_REPLY_MS 100
+
+// Ждёт управляющий кадр с командой command не дольше BOARD_REPLY_MS;
+// args — буфер на PROTOCOL_MAX_DATA байт
+bool boardAwaitReply(SerialTransport &port, ProtocolDecoder &decoder, uint8_t command, uint8_t *args, uint8_t *size);
+
+// Запрос с повторами: ответ мог потеряться или плата ещё не успела сменить скорость.
+// reply — буфер на PROTOCOL_MAX_DATA байт
+bool boardRequest(SerialTransport &port, ProtocolDecoder &decoder, uint8_t command, const uint8_t *args, uint8_t size,
+                  uint8_t *reply, uint8_t *replySize);
+
+// Кривая яркости PROTOCOL_CURVE_* для всех каналов платы. false — плата
+// не подтвердила (прошивка без SET_CURVE)
+bool requestBrightnessCurve(SerialTransport &port, uint8_t curve);
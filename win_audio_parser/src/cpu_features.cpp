@@ -0,0 +1,75 @@
+#include "cpu_features.h"
+
+#if defined(DSP_X86) && defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+#if defined(DSP_X86)
+#include <xmmintrin.h>
+#endif
+
+SimdLevel detectSimdLevel()
+{
+#if !defined(DSP_X86)
+    return SimdLevel::Scalar;
+#elif defined(_MSC_VER) && !defined(__clang__)
+    int regs[4];
+    __cpuid(regs, 0);
+    const int maxLeaf = regs[0];
+
+    __cpuid(regs, 1);
+    const bool sse2 = (regs[3] & (1 << 26)) != 0;
+    const bool osxsave = (regs[2] & (1 << 27)) != 0;
+    const bool avx = (regs[2] & (1 << 28)) != 0;
+    const bool fma = (regs[2] & (1 << 12)) != 0;
+    if (!sse2)
+        return SimdLevel::Scalar;
+    if (!osxsave || !avx || maxLeaf < 7)
+        return SimdLevel::Sse2;
+
+    // ОС должна сохранять YMM (биты 1-2) и для AVX-512 ещё opmask/ZMM (биты 5-7)
+    const unsigned long long xcr0 = _xgetbv(0);
+    __cpuidex(regs, 7, 0);
+    const bool avx2 = (regs[1] & (1 << 5)) != 0 && fma && (xcr0 & 0x6) == 0x6;
+    const bool avx512 = (regs[1] & (1 << 16)) != 0 && (xcr0 & 0xE6) == 0xE6;
+
+    if (avx512)
+        return SimdLevel::Avx512;
+    if (avx2)
+        return SimdLevel::Avx2;
+    return SimdLevel::Sse2;
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return SimdLevel::Avx512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return SimdLevel::Avx2;
+    if (__builtin_cpu_supports("sse2"))
+        return SimdLevel::Sse2;
+    return SimdLevel::Scalar;
+#endif
+}
+
+const char *simdLevelName(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::Sse2:
+        return "SSE2";
+    case SimdLevel::Avx2:
+        return "AVX2";
+    case SimdLevel::Avx512:
+        return "AVX-512";
+    case SimdLevel::Scalar:
+    default:
+        return "scalar";
+    }
+}
+
+void enableFlushToZero()
+{
+#if defined(DSP_X86)
+    // Биты FTZ (15) и DAZ (6) регистра MXCSR
+    _mm_setcsr(_mm_getcsr() | 0x8040);
+#endif
+}
@@ -0,0 +1,33 @@
+// Определение набора SIMD-инструкций процессора во время работы
+#pragma once
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define DSP_X86 1
+#endif
+
+// GCC/Clang требуют явно разрешить набор инструкций для отдельной функции,
+// MSVC пускает интринсики в любой функции без флагов
+#if defined(_MSC_VER) && !defined(__clang__)
+#define DSP_TARGET_AVX2
+#define DSP_TARGET_AVX512
+#else
+#define DSP_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define DSP_TARGET_AVX512 __attribute__((target("avx512f")))
+#endif
+
+enum class SimdLevel
+{
+    Scalar,
+    Sse2,
+    Avx2,
+    Avx512,
+};
+
+// Лучший уровень, который поддерживают и процессор, и ОС (сохранение регистров)
+SimdLevel detectSimdLevel();
+
+const char *simdLevelName(SimdLevel level);
+
+// Денормалы в хвостах IIR-фильтров на тишине тормозят x86 в десятки раз:
+// включает flush-to-zero/denormals-are-zero для текущего потока
+void enableFlushToZero();
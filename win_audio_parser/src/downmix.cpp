@@ -0,0 +1,242 @@
+#include "downmix.h"
+#include <cmath>
+#include <cstring>
+
+#if defined(DSP_X86)
+#include <immintrin.h>
+#endif
+
+bool parseDownmixMode(const char *name, DownmixMode *out)
+{
+    if (strcmp(name, "mid") == 0)
+        *out = DownmixMode::Mid;
+    else if (strcmp(name, "side") == 0)
+        *out = DownmixMode::Side;
+    else if (strcmp(name, "max") == 0)
+        *out = DownmixMode::Max;
+    else if (strcmp(name, "split") == 0)
+        *out = DownmixMode::Split;
+    else
+        return false;
+    return true;
+}
+
+// Скалярные ядра работают с любым числом каналов и дорабатывают хвосты векторных
+
+static void downmixMidScalar(const float *in, size_t frames, int channels, float *out)
+{
+    const float scale = 1.0f / channels;
+    for (size_t i = 0; i < frames; i++)
+    {
+        float sum = 0.0f;
+        for (int c = 0; c < channels; c++)
+            sum += in[i * channels + c];
+        out[i] = sum * scale;
+    }
+}
+
+static void downmixSideScalar(const float *in, size_t frames, int channels, float *out)
+{
+    // В моно разностного сигнала нет; в многоканальном берём фронтальную пару
+    if (channels < 2)
+    {
+        memset(out, 0, frames * sizeof(float));
+        return;
+    }
+    for (size_t i = 0; i < frames; i++)
+        out[i] = (in[i * channels] - in[i * channels + 1]) * 0.5f;
+}
+
+static void downmixMaxScalar(const float *in, size_t frames, int channels, float *out)
+{
+    for (size_t i = 0; i < frames; i++)
+    {
+        float best = in[i * channels];
+        for (int c = 1; c < channels; c++)
+        {
+            const float x = in[i * channels + c];
+            if (fabsf(x) > fabsf(best))
+                best = x;
+        }
+        out[i] = best;
+    }
+}
+
+static void deinterleaveScalar(const float *in, size_t frames, int channels, float *const *out, int outCount)
+{
+    for (int c = 0; c < outCount; c++)
+    {
+        float *dst = out[c];
+        for (size_t i = 0; i < frames; i++)
+            dst[i] = in[i * channels + c];
+    }
+}
+
+#if defined(DSP_X86)
+
+// [L0 R0 L1 R1] [L2 R2 L3 R3] -> [L0 L1 L2 L3] и [R0 R1 R2 R3]
+template <DownmixMode M>
+static inline __m128 combineSse2(__m128 l, __m128 r)
+{
+    if (M == DownmixMode::Side)
+        return _mm_mul_ps(_mm_sub_ps(l, r), _mm_set1_ps(0.5f));
+    if (M == DownmixMode::Max)
+    {
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+        const __m128 takeLeft = _mm_cmpge_ps(_mm_and_ps(l, absMask), _mm_and_ps(r, absMask));
+        return _mm_or_ps(_mm_and_ps(takeLeft, l), _mm_andnot_ps(takeLeft, r));
+    }
+    return _mm_mul_ps(_mm_add_ps(l, r), _mm_set1_ps(0.5f));
+}
+
+template <DownmixMode M>
+static void downmixStereoSse2(const float *in, size_t frames, int channels, float *out)
+{
+    size_t i = 0;
+    if (channels == 2)
+    {
+        for (; i + 4 <= frames; i += 4)
+        {
+            const __m128 a = _mm_loadu_ps(in + 2 * i);
+            const __m128 b = _mm_loadu_ps(in + 2 * i + 4);
+            const __m128 l = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+            const __m128 r = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+            _mm_storeu_ps(out + i, combineSse2<M>(l, r));
+        }
+    }
+
+    const float *tailIn = in + i * channels;
+    if (M == DownmixMode::Side)
+        downmixSideScalar(tailIn, frames - i, channels, out + i);
+    else if (M == DownmixMode::Max)
+        downmixMaxScalar(tailIn, frames - i, channels, out + i);
+    else
+        downmixMidScalar(tailIn, frames - i, channels, out + i);
+}
+
+static void deinterleaveSse2(const float *in, size_t frames, int channels, float *const *out, int outCount)
+{
+    size_t i = 0;
+    if (channels == 2 && outCount == 2)
+    {
+        for (; i + 4 <= frames; i += 4)
+        {
+            const __m128 a = _mm_loadu_ps(in + 2 * i);
+            const __m128 b = _mm_loadu_ps(in + 2 * i + 4);
+            _mm_storeu_ps(out[0] + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+            _mm_storeu_ps(out[1] + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+        }
+    }
+
+    float *tailOut[MAX_CAPTURE_CHANNELS];
+    for (int c = 0; c < outCount; c++)
+        tailOut[c] = out[c] + i;
+    deinterleaveScalar(in + i * channels, frames - i, channels, tailOut, outCount);
+}
+
+// В AVX2 shuffle работает внутри 128-битных половин: после него порядок
+// кадров [0 1 4 5 | 2 3 6 7], его возвращает перестановка 64-битных пар
+DSP_TARGET_AVX2 static inline __m256 restoreOrderAvx2(__m256 v)
+{
+    return _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(v), _MM_SHUFFLE(3, 1, 2, 0)));
+}
+
+template <DownmixMode M>
+DSP_TARGET_AVX2 static inline __m256 combineAvx2(__m256 l, __m256 r)
+{
+    if (M == DownmixMode::Side)
+        return _mm256_mul_ps(_mm256_sub_ps(l, r), _mm256_set1_ps(0.5f));
+    if (M == DownmixMode::Max)
+    {
+        const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+        const __m256 takeLeft = _mm256_cmp_ps(_mm256_and_ps(l, absMask), _mm256_and_ps(r, absMask), _CMP_GE_OQ);
+        return _mm256_blendv_ps(r, l, takeLeft);
+    }
+    return _mm256_mul_ps(_mm256_add_ps(l, r), _mm256_set1_ps(0.5f));
+}
+
+template <DownmixMode M>
+DSP_TARGET_AVX2 static void downmixStereoAvx2(const float *in, size_t frames, int channels, float *out)
+{
+    size_t i = 0;
+    if (channels == 2)
+    {
+        for (; i + 8 <= frames; i += 8)
+        {
+            const __m256 a = _mm256_loadu_ps(in + 2 * i);
+            const __m256 b = _mm256_loadu_ps(in + 2 * i + 8);
+            const __m256 l = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+            const __m256 r = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+            // Операции поэлементные, так что порядок восстанавливается один раз в конце
+            _mm256_storeu_ps(out + i, restoreOrderAvx2(combineAvx2<M>(l, r)));
+        }
+    }
+
+    // Хвост короче 8 кадров досчитывает SSE2-версия
+    downmixStereoSse2<M>(in + i * channels, frames - i, channels, out + i);
+}
+
+DSP_TARGET_AVX2 static void deinterleaveAvx2(const float *in, size_t frames, int channels, float *const *out, int outCount)
+{
+    size_t i = 0;
+    if (channels == 2 && outCount == 2)
+    {
+        for (; i + 8 <= frames; i += 8)
+        {
+            const __m256 a = _mm256_loadu_ps(in + 2 * i);
+            const __m256 b = _mm256_loadu_ps(in + 2 * i + 8);
+            _mm256_storeu_ps(out[0] + i, restoreOrderAvx2(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0))));
+            _mm256_storeu_ps(out[1] + i, restoreOrderAvx2(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1))));
+        }
+    }
+
+    float *tailOut[MAX_CAPTURE_CHANNELS];
+    for (int c = 0; c < outCount; c++)
+        tailOut[c] = out[c] + i;
+    deinterleaveSse2(in + i * channels, frames - i, channels, tailOut, outCount);
+}
+
+#endif
+
+DownmixKernel downmixKernel(DownmixMode mode, SimdLevel level)
+{
+#if defined(DSP_X86)
+    // Ядро упирается в память, AVX-512 ничего не добавляет
+    if (level >= SimdLevel::Avx2)
+    {
+        if (mode == DownmixMode::Side)
+            return downmixStereoAvx2<DownmixMode::Side>;
+        if (mode == DownmixMode::Max)
+            return downmixStereoAvx2<DownmixMode::Max>;
+        return downmixStereoAvx2<DownmixMode::Mid>;
+    }
+    if (level >= SimdLevel::Sse2)
+    {
+        if (mode == DownmixMode::Side)
+            return downmixStereoSse2<DownmixMode::Side>;
+        if (mode == DownmixMode::Max)
+            return downmixStereoSse2<DownmixMode::Max>;
+        return downmixStereoSse2<DownmixMode::Mid>;
+    }
+#else
+    (void)level;
+#endif
+    if (mode == DownmixMode::Side)
+        return downmixSideScalar;
+    if (mode == DownmixMode::Max)
+        return downmixMaxScalar;
+    return downmixMidScalar;
+}
+
+DeinterleaveKernel deinterleaveKernel(SimdLevel level)
+{
+#if defined(DSP_X86)
+    if (level >= SimdLevel::Avx2)
+        return deinterleaveAvx2;
+    if (level >= SimdLevel::Sse2)
+        return deinterleaveSse2;
+#else
+    (void)level;
+#endif
+    return deinterleaveScalar;
+}
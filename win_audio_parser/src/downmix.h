@@ -0,0 +1,31 @@
+// Сведение интерлейсного буфера захвата в моно или разбор по каналам
+#pragma once
+#include <cstddef>
+#include "cpu_features.h"
+
+// Больше каналов не анализируется раздельно: 7.1 — предел для loopback
+#define MAX_CAPTURE_CHANNELS 8
+// Кадров за один проход ядра в аудиопотоке: буферы на стеке/в состоянии, без new
+#define DOWNMIX_BLOCK 256
+
+enum class DownmixMode
+{
+    Mid,   // Среднее всех каналов
+    Side,  // (L - R) / 2: то, что исчезает при сложении в моно
+    Max,   // Сэмпл канала с наибольшим модулем
+    Split, // Каналы анализируются раздельно, каждый своей группой полос
+};
+
+// mid, side, max или split
+bool parseDownmixMode(const char *name, DownmixMode *out);
+
+// interleaved — frames кадров по channels сэмплов; в out пишется frames сэмплов
+typedef void (*DownmixKernel)(const float *interleaved, size_t frames, int channels, float *out);
+
+// Раскладывает первые outCount каналов в отдельные массивы out[c][frames]
+typedef void (*DeinterleaveKernel)(const float *interleaved, size_t frames, int channels, float *const *out, int outCount);
+
+// Векторные ядра написаны для стерео; при другом числе каналов они сами
+// уходят в скалярный путь. Для Split возвращается ядро Mid.
+DownmixKernel downmixKernel(DownmixMode mode, SimdLevel level);
+DeinterleaveKernel deinterleaveKernel(SimdLevel level);
@@ -0,0 +1,65 @@
+#include "engine_options.h"
+#include <iostream>
+#include "filter_bank_engine.h"
+#include "multires_engine.h"
+
+// Шаг и окно — общие для всех движков. maxHop — верхний предел шага у этого
+// движка, 0 — предела нет
+static bool configureEngine(BandEngine &engine, const EngineOptions &options, int maxHop)
+{
+    if (options.hopSize != 0 && !engine.setHopSize(options.hopSize))
+    {
+        if (maxHop > 0)
+            std::cerr << "Error: hop size must be in 1.." << maxHop << std::endl;
+        else
+            std::cerr << "Error: hop size must be at least 1" << std::endl;
+        return false;
+    }
+    engine.setWindow(options.windowType);
+    return true;
+}
+
+static bool fftSizeValid(int size)
+{
+    return size >= MIN_FFT_SIZE && size <= MAX_FFT_SIZE && (size & (size - 1)) == 0;
+}
+
+std::unique_ptr<BandEngine> makeEngine(const EngineOptions &options)
+{
+    // Банку фильтров размер FFT не нужен: остальные параметры к нему не относятся
+    if (options.filterBank)
+    {
+        std::unique_ptr<BandEngine> engine(new FilterBankEngine());
+        return configureEngine(*engine, options, 0) ? std::move(engine) : nullptr;
+    }
+
+    if (!fftSizeValid(options.fftSize))
+    {
+        std::cerr << "Error: FFT size must be a power of two in " << MIN_FFT_SIZE << ".." << MAX_FFT_SIZE << std::endl;
+        return nullptr;
+    }
+
+    // --fft в многоразрешающем режиме — верхний предел размера для басовых полос
+    if (options.multiResolution)
+    {
+        std::unique_ptr<MultiResolutionEngine> multi(new MultiResolutionEngine(options.fftSize));
+        if (!multi->setDecimation(options.decimation))
+        {
+            std::cerr << "Error: decimation factor must be 4, 8 or 16" << std::endl;
+            return nullptr;
+        }
+        if (!multi->setDecimatedFftSize(options.bassFftSize))
+        {
+            std::cerr << "Error: bass FFT size must be a power of two in " << MIN_FFT_SIZE << ".." << MAX_FFT_SIZE << std::endl;
+            return nullptr;
+        }
+        if (!configureEngine(*multi, options, 0))
+            return nullptr;
+        return std::unique_ptr<BandEngine>(multi.release());
+    }
+
+    std::unique_ptr<BandEngine> engine = makeFftEngine(options.fftSize);
+    if (!engine || !configureEngine(*engine, options, options.fftSize))
+        return nullptr;
+    return engine;
+}
@@ -0,0 +1,20 @@
+// Выбор и настройка движка полос по параметрам командной строки
+#pragma once
+#include <memory>
+#include "audio_dsp.h"
+#include "band_engine.h"
+
+// В режиме split и в пакетном анализе по этим параметрам строится несколько движков
+struct EngineOptions
+{
+    int fftSize = DEFAULT_FFT_SIZE;
+    int hopSize = 0; // 0 — шаг по умолчанию для выбранного движка
+    bool multiResolution = false;
+    int decimation = 1;
+    int bassFftSize = 0; // Наименьший FFT басов после дециматора; 0 — по числу бинов
+    bool filterBank = false;
+    WindowType windowType = WindowType::Hann;
+};
+
+// nullptr, если параметры недопустимы; причина уже выведена в stderr
+std::unique_ptr<BandEngine> makeEngine(const EngineOptions &options);
@@ -0,0 +1,442 @@
+#include "fft_backend.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <vector>
+#include "cpu_features.h"
+#include "split_radix_fft.h"
+#if !defined(DSP_NO_KISSFFT)
+extern "C"
+{
+#include "kiss_fftr.h"
+}
+
+// Ядра спектра читают kiss_fft_cpx как массив float (re, im)
+static_assert(sizeof(kiss_fft_cpx) == 2 * sizeof(float), "kissfft must be built with float scalars");
+#endif
+
+// Сколько прогонов на каждую реализацию при выборе Auto
+#define FFT_AUTO_TRIALS 64
+
+#if !defined(DSP_NO_KISSFFT)
+struct KissFft : FftBackend
+{
+    kiss_fftr_cfg config;
+
+    explicit KissFft(int n) { config = kiss_fftr_alloc(n, 0, NULL, NULL); }
+    ~KissFft() override { kiss_fftr_free(config); }
+
+    KissFft(const KissFft &) = delete;
+    KissFft &operator=(const KissFft &) = delete;
+
+    void forward(const float *in, float *out) override
+    {
+        kiss_fftr(config, in, (kiss_fft_cpx *)out);
+    }
+
+    const char *name() const override { return "kiss"; }
+};
+#endif
+
+// W_n^k, k <= n / 2: разбор спектра комплексного FFT на n / 2 точек в вещественный
+static void realSplitTwiddles(int n, std::vector<float> &re, std::vector<float> &im)
+{
+    const double pi = 3.14159265358979323846;
+    re.resize(n / 2 + 1);
+    im.resize(n / 2 + 1);
+    for (int k = 0; k <= n / 2; k++)
+    {
+        re[k] = (float)cos(-2.0 * pi * k / n);
+        im[k] = (float)sin(-2.0 * pi * k / n);
+    }
+}
+
+// xr, xi — FFT на m точек от z[j] = in[2j] + i in[2j + 1]. Z' = conj Z[m - k]:
+// X[k] = (Z + Z') / 2 + W_n^k (Z - Z') / 2i
+static void unpackRealSpectrum(const float *xr, const float *xi, const float *splitRe, const float *splitIm,
+                               int m, float *out)
+{
+    for (int k = 0; k <= m; k++)
+    {
+        const int k0 = k == m ? 0 : k;
+        const int k1 = k == 0 ? 0 : m - k;
+        const float zr = xr[k0], zi = xi[k0];
+        const float cr = xr[k1], ci = -xi[k1];
+
+        const float er = 0.5f * (zr + cr), ei = 0.5f * (zi + ci);
+        const float odR = 0.5f * (zi - ci), odI = -0.5f * (zr - cr);
+
+        out[2 * k] = er + odR * splitRe[k] - odI * splitIm[k];
+        out[2 * k + 1] = ei + odR * splitIm[k] + odI * splitRe[k];
+    }
+}
+
+// Вещественный FFT на n точек через комплексный на m = n / 2: чётные сэмплы —
+// действительная часть, нечётные — мнимая. Комплексный FFT — Stockham
+// (без перестановки битов), проходы radix-4 и один radix-2 при нечётной
+// степени. Массивы re и im раздельные: внутренние циклы идут подряд по памяти
+// и векторизуются компилятором.
+struct Radix4Fft : FftBackend
+{
+    int n;
+    int m;
+    std::vector<float> twRe, twIm;       // W_m^k = exp(-2 pi i k / m), k < m
+    std::vector<float> splitRe, splitIm; // W_n^k для разбора спектра, k <= m
+    std::vector<float> aRe, aIm, bRe, bIm;
+
+    explicit Radix4Fft(int size) : n(size), m(size / 2)
+    {
+        const double pi = 3.14159265358979323846;
+        twRe.resize(m);
+        twIm.resize(m);
+        for (int k = 0; k < m; k++)
+        {
+            twRe[k] = (float)cos(-2.0 * pi * k / m);
+            twIm[k] = (float)sin(-2.0 * pi * k / m);
+        }
+        realSplitTwiddles(n, splitRe, splitIm);
+        aRe.resize(m);
+        aIm.resize(m);
+        bRe.resize(m);
+        bIm.resize(m);
+    }
+
+    void forward(const float *in, float *out) override
+    {
+        for (int k = 0; k < m; k++)
+        {
+            aRe[k] = in[2 * k];
+            aIm[k] = in[2 * k + 1];
+        }
+
+        float *xr = aRe.data(), *xi = aIm.data();
+        float *yr = bRe.data(), *yi = bIm.data();
+
+        // Длина подпреобразования len и число чередующихся подпреобразований s: len * s == m
+        int len = m;
+        int s = 1;
+        for (; len >= 4; len /= 4, s *= 4)
+        {
+            const int quarter = len / 4;
+            for (int p = 0; p < quarter; p++)
+            {
+                const float w1r = twRe[p * s], w1i = twIm[p * s];
+                const float w2r = twRe[2 * p * s], w2i = twIm[2 * p * s];
+                const float w3r = twRe[3 * p * s], w3i = twIm[3 * p * s];
+
+                const float *ar = xr + s * p, *ai = xi + s * p;
+                const float *br = ar + s * quarter, *bi = ai + s * quarter;
+                const float *cr = br + s * quarter, *ci = bi + s * quarter;
+                const float *dr = cr + s * quarter, *di = ci + s * quarter;
+                float *y0r = yr + s * 4 * p, *y0i = yi + s * 4 * p;
+                float *y1r = y0r + s, *y1i = y0i + s;
+                float *y2r = y1r + s, *y2i = y1i + s;
+                float *y3r = y2r + s, *y3i = y2i + s;
+
+                for (int q = 0; q < s; q++)
+                {
+                    const float apcR = ar[q] + cr[q], apcI = ai[q] + ci[q];
+                    const float amcR = ar[q] - cr[q], amcI = ai[q] - ci[q];
+                    const float bpdR = br[q] + dr[q], bpdI = bi[q] + di[q];
+                    // -i * (b - d)
+                    const float jR = bi[q] - di[q], jI = dr[q] - br[q];
+
+                    y0r[q] = apcR + bpdR;
+                    y0i[q] = apcI + bpdI;
+
+                    const float t1r = amcR + jR, t1i = amcI + jI;
+                    y1r[q] = t1r * w1r - t1i * w1i;
+                    y1i[q] = t1r * w1i + t1i * w1r;
+
+                    const float t2r = apcR - bpdR, t2i = apcI - bpdI;
+                    y2r[q] = t2r * w2r - t2i * w2i;
+                    y2i[q] = t2r * w2i + t2i * w2r;
+
+                    const float t3r = amcR - jR, t3i = amcI - jI;
+                    y3r[q] = t3r * w3r - t3i * w3i;
+                    y3i[q] = t3r * w3i + t3i * w3r;
+                }
+            }
+            std::swap(xr, yr);
+            std::swap(xi, yi);
+        }
+
+        if (len == 2)
+        {
+            for (int q = 0; q < s; q++)
+            {
+                const float ar = xr[q], ai = xi[q];
+                const float br = xr[q + s], bi = xi[q + s];
+                yr[q] = ar + br;
+                yi[q] = ai + bi;
+                yr[q + s] = ar - br;
+                yi[q + s] = ai - bi;
+            }
+            std::swap(xr, yr);
+            std::swap(xi, yi);
+        }
+
+        unpackRealSpectrum(xr, xi, splitRe.data(), splitIm.data(), m, out);
+    }
+
+    const char *name() const override { return "radix4"; }
+};
+
+// Тот же вещественный FFT через комплексный на m = n / 2, но комплексный —
+// рекурсивный split-radix с прореживанием по времени: FFT чётных отсчётов на
+// m / 2 и отсчётов 4j+1, 4j+3 на m / 4 сшиваются L-бабочкой. Вход не
+// переставляется: рекурсия читает его с растущим шагом, и первый шаг 2 сам
+// разбирает вещественные сэмплы на re и im. Бабочка — явные SSE2/AVX2/AVX-512
+// по detectSimdLevel, остаток короче регистра и листья на 2, 4 и 8 точек скалярные.
+struct SplitRadixFft : FftBackend
+{
+    int n;
+    int m;
+    SplitRadixKernel kernel;
+    // Для длины len = 2^b с b >= 4 с twOffset[b]: W_len^k re, im, затем W_len^3k re, im, по len / 4
+    std::vector<float> tw;
+    int twOffset[32];
+    std::vector<float> splitRe, splitIm;
+    std::vector<float> zRe, zIm;
+
+    explicit SplitRadixFft(int size) : n(size), m(size / 2), kernel(splitRadixKernel(detectSimdLevel()))
+    {
+        const double pi = 3.14159265358979323846;
+        int bits = 0;
+        for (int len = 1; len <= m; len *= 2, bits++)
+        {
+            twOffset[bits] = (int)tw.size();
+            if (len < 16)
+                continue;
+            const int quarter = len / 4;
+            tw.resize(tw.size() + 4 * quarter);
+            float *w = tw.data() + twOffset[bits];
+            for (int k = 0; k < quarter; k++)
+            {
+                w[k] = (float)cos(-2.0 * pi * k / len);
+                w[quarter + k] = (float)sin(-2.0 * pi * k / len);
+                w[2 * quarter + k] = (float)cos(-2.0 * pi * 3 * k / len);
+                w[3 * quarter + k] = (float)sin(-2.0 * pi * 3 * k / len);
+            }
+        }
+        realSplitTwiddles(n, splitRe, splitIm);
+        zRe.resize(m);
+        zIm.resize(m);
+    }
+
+    static void leaf2(const float *inRe, const float *inIm, int stride, float *re, float *im)
+    {
+        const float ar = inRe[0], ai = inIm[0];
+        const float br = inRe[stride], bi = inIm[stride];
+        re[0] = ar + br;
+        im[0] = ai + bi;
+        re[1] = ar - br;
+        im[1] = ai - bi;
+    }
+
+    static void leaf4(const float *inRe, const float *inIm, int stride, float *re, float *im)
+    {
+        const float ar = inRe[0], ai = inIm[0];
+        const float br = inRe[stride], bi = inIm[stride];
+        const float cr = inRe[2 * stride], ci = inIm[2 * stride];
+        const float dr = inRe[3 * stride], di = inIm[3 * stride];
+        const float apcR = ar + cr, apcI = ai + ci;
+        const float amcR = ar - cr, amcI = ai - ci;
+        const float bpdR = br + dr, bpdI = bi + di;
+        const float bmdR = br - dr, bmdI = bi - di;
+        re[0] = apcR + bpdR;
+        im[0] = apcI + bpdI;
+        re[2] = apcR - bpdR;
+        im[2] = apcI - bpdI;
+        // (a - c) -+ i (b - d)
+        re[1] = amcR + bmdI;
+        im[1] = amcI - bmdR;
+        re[3] = amcR - bmdI;
+        im[3] = amcI + bmdR;
+    }
+
+    // Лист на 8 точек без вызова ядра: W_8 = (1 - i) / sqrt 2, W_8^3 = -(1 + i) / sqrt 2
+    static void leaf8(const float *inRe, const float *inIm, int stride, float *re, float *im)
+    {
+        const float h = 0.70710678118654752f;
+        leaf4(inRe, inIm, 2 * stride, re, im);
+        leaf2(inRe + stride, inIm + stride, 4 * stride, re + 4, im + 4);
+        leaf2(inRe + 3 * stride, inIm + 3 * stride, 4 * stride, re + 6, im + 6);
+
+        // k = 0: множители единичные
+        float sr = re[4] + re[6], si = im[4] + im[6];
+        float dr = re[4] - re[6], di = im[4] - im[6];
+        float u0r = re[0], u0i = im[0], u1r = re[2], u1i = im[2];
+        re[0] = u0r + sr;
+        im[0] = u0i + si;
+        re[4] = u0r - sr;
+        im[4] = u0i - si;
+        re[2] = u1r + di;
+        im[2] = u1i - dr;
+        re[6] = u1r - di;
+        im[6] = u1i + dr;
+
+        // k = 1
+        const float ar = h * (re[5] + im[5]), ai = h * (im[5] - re[5]);
+        const float br = h * (im[7] - re[7]), bi = -h * (re[7] + im[7]);
+        sr = ar + br;
+        si = ai + bi;
+        dr = ar - br;
+        di = ai - bi;
+        u0r = re[1];
+        u0i = im[1];
+        u1r = re[3];
+        u1i = im[3];
+        re[1] = u0r + sr;
+        im[1] = u0i + si;
+        re[5] = u0r - sr;
+        im[5] = u0i - si;
+        re[3] = u1r + di;
+        im[3] = u1i - dr;
+        re[7] = u1r - di;
+        im[7] = u1i + dr;
+    }
+
+    // len точек входа с шагом stride -> re[0..len), im[0..len) по порядку частот
+    void transform(const float *inRe, const float *inIm, int stride, float *re, float *im, int len, int bits)
+    {
+        if (len <= 8)
+        {
+            if (len == 8)
+                leaf8(inRe, inIm, stride, re, im);
+            else if (len == 4)
+                leaf4(inRe, inIm, stride, re, im);
+            else
+                leaf2(inRe, inIm, stride, re, im);
+            return;
+        }
+
+        const int half = len / 2, quarter = len / 4;
+        transform(inRe, inIm, 2 * stride, re, im, half, bits - 1);
+        transform(inRe + stride, inIm + stride, 4 * stride, re + half, im + half, quarter, bits - 2);
+        transform(inRe + 3 * stride, inIm + 3 * stride, 4 * stride, re + half + quarter, im + half + quarter,
+                  quarter, bits - 2);
+
+        const float *w = tw.data() + twOffset[bits];
+        kernel(re, im, quarter, w, w + quarter, w + 2 * quarter, w + 3 * quarter);
+    }
+
+    void forward(const float *in, float *out) override
+    {
+        int bits = 0;
+        while ((1 << bits) < m)
+            bits++;
+        transform(in, in + 1, 2, zRe.data(), zIm.data(), m, bits);
+        unpackRealSpectrum(zRe.data(), zIm.data(), splitRe.data(), splitIm.data(), m, out);
+    }
+
+    const char *name() const override { return "split-radix"; }
+};
+
+static FftBackendType defaultBackend = DSP_DEFAULT_FFT_BACKEND;
+
+void setDefaultFftBackend(FftBackendType type)
+{
+    defaultBackend = type;
+}
+
+FftBackendType defaultFftBackend()
+{
+    return defaultBackend;
+}
+
+bool fftBackendAvailable(FftBackendType type)
+{
+#if defined(DSP_NO_KISSFFT)
+    return type != FftBackendType::Kiss;
+#else
+    (void)type;
+    return true;
+#endif
+}
+
+bool parseFftBackend(const char *name, FftBackendType *out)
+{
+    if (strcmp(name, "kiss") == 0 && fftBackendAvailable(FftBackendType::Kiss))
+        *out = FftBackendType::Kiss;
+    else if (strcmp(name, "radix4") == 0)
+        *out = FftBackendType::Radix4;
+    else if (strcmp(name, "split-radix") == 0)
+        *out = FftBackendType::SplitRadix;
+    else if (strcmp(name, "auto") == 0)
+        *out = FftBackendType::Auto;
+    else
+        return false;
+    return true;
+}
+
+static double secondsPerRun(FftBackend &fft, int n)
+{
+    std::vector<float> in(n), out(n + 2);
+    for (int i = 0; i < n; i++)
+        in[i] = (float)((i * 7919) % 1000) / 1000.0f - 0.5f;
+
+    fft.forward(in.data(), out.data()); // Прогрев кэша и таблиц
+    const auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < FFT_AUTO_TRIALS; t++)
+        fft.forward(in.data(), out.data());
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+FftBackendType fastestFftBackend(int n)
+{
+    // Движки одного размера создаются часто (пакетный режим, раздельные
+    // каналы), а замер дольше создания: мерим каждый размер один раз
+    static std::mutex lock;
+    static FftBackendType winners[32];
+    static bool measured[32];
+
+    int log2n = 0;
+    while ((1 << log2n) < n)
+        log2n++;
+
+    std::lock_guard<std::mutex> guard(lock);
+    if (!measured[log2n])
+    {
+        const FftBackendType candidates[] = {FftBackendType::Radix4, FftBackendType::SplitRadix, FftBackendType::Kiss};
+        FftBackendType best = FftBackendType::Radix4;
+        double bestTime = 1e30;
+        for (FftBackendType type : candidates)
+        {
+            if (!fftBackendAvailable(type))
+                continue;
+            std::unique_ptr<FftBackend> fft = makeFftBackend(type, n);
+            // Лучший из трёх замеров, чтобы случайная помеха не решила исход
+            double time = 1e30;
+            for (int round = 0; round < 3; round++)
+                time = std::min(time, secondsPerRun(*fft, n));
+            if (time < bestTime)
+            {
+                bestTime = time;
+                best = type;
+            }
+        }
+        winners[log2n] = best;
+        measured[log2n] = true;
+    }
+    return winners[log2n];
+}
+
+std::unique_ptr<FftBackend> makeFftBackend(FftBackendType type, int n)
+{
+    if (n < 16 || (n & (n - 1)) != 0)
+        return nullptr;
+
+    if (type == FftBackendType::Auto)
+        type = fastestFftBackend(n);
+    if (type == FftBackendType::SplitRadix)
+        return std::unique_ptr<FftBackend>(new SplitRadixFft(n));
+#if !defined(DSP_NO_KISSFFT)
+    if (type == FftBackendType::Kiss)
+        return std::unique_ptr<FftBackend>(new KissFft(n));
+#endif
+    // Radix4, а также Kiss в сборке без kissfft
+    return std::unique_ptr<FftBackend>(new Radix4Fft(n));
+}
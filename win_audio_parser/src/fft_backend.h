@@ -0,0 +1,44 @@
+// Реализации прямого вещественного FFT за общим интерфейсом: kissfft, своя
+// radix-4 и свой split-radix на SIMD. Выбор — при сборке (FFT_BACKEND в CMake)
+// или при запуске (--fft-backend). Сборка с DSP_NO_KISSFFT обходится без kissfft.
+#pragma once
+#include <memory>
+
+enum class FftBackendType
+{
+    Kiss,       // kiss_fftr из FetchContent
+    Radix4,     // Своя: комплексный Stockham radix-4 на N/2 точек + разбор вещественного спектра
+    SplitRadix, // Своя: комплексный split-radix на N/2 точек, бабочки SSE2/AVX2/AVX-512 по SimdLevel
+    Auto,       // Самая быстрая на этом процессоре для данного размера, меряется при создании
+};
+
+// Реализация по умолчанию для сборки; CMake может переопределить
+#ifndef DSP_DEFAULT_FFT_BACKEND
+#define DSP_DEFAULT_FFT_BACKEND FftBackendType::Auto
+#endif
+
+struct FftBackend
+{
+    virtual ~FftBackend() = default;
+
+    // in — n вещественных сэмплов; out — n / 2 + 1 пар (re, im) подряд, без нормировки
+    virtual void forward(const float *in, float *out) = 0;
+    virtual const char *name() const = 0;
+};
+
+// n — степень двойки от 16; nullptr для неподдерживаемого размера.
+// Kiss в сборке без kissfft отдаёт Radix4
+std::unique_ptr<FftBackend> makeFftBackend(FftBackendType type, int n);
+
+// Какой реализацией будут считать новые движки; задаётся до их создания
+void setDefaultFftBackend(FftBackendType type);
+FftBackendType defaultFftBackend();
+
+// Kiss недоступен в сборке с DSP_NO_KISSFFT, остальные есть всегда
+bool fftBackendAvailable(FftBackendType type);
+
+// kiss, radix4, split-radix или auto; kiss — только если он есть в сборке
+bool parseFftBackend(const char *name, FftBackendType *out);
+
+// Победитель замера для Auto на этом размере; результат запоминается
+FftBackendType fastestFftBackend(int n);
@@ -0,0 +1,274 @@
+#include "filter_bank_engine.h"
+#include "latency_stats.h"
+#include <cmath>
+#include <cstring>
+
+#if defined(DSP_X86)
+#include <immintrin.h>
+#endif
+
+// Пик огибающей синуса с амплитудой A равен A, а FFT с окном Ханна даёт A / 2:
+// приводим к той же шкале, чтобы яркость не зависела от движка
+#define FILTER_BANK_LEVEL_SCALE 0.5f
+
+// Все ядра идут по группам полос во внешнем цикле и по сэмплам во внутреннем:
+// состояние группы живёт в регистрах весь блок
+
+static void filterBankScalar(FilterBankState &st, const float *samples, size_t n)
+{
+    for (int lane = 0; lane < st.activeLanes; lane++)
+    {
+        float z1[FilterBankState::SECTIONS], z2[FilterBankState::SECTIONS];
+        for (int s = 0; s < FilterBankState::SECTIONS; s++)
+        {
+            z1[s] = st.z1[s][lane];
+            z2[s] = st.z2[s][lane];
+        }
+        float env = st.envelope[lane];
+
+        for (size_t i = 0; i < n; i++)
+        {
+            float x = samples[i];
+            for (int s = 0; s < FilterBankState::SECTIONS; s++)
+            {
+                const float y = st.b0[s][lane] * x + z1[s];
+                z1[s] = st.b1[s][lane] * x - st.a1[s][lane] * y + z2[s];
+                z2[s] = st.b2[s][lane] * x - st.a2[s][lane] * y;
+                x = y;
+            }
+            env *= st.release;
+            if (fabsf(x) > env)
+                env = fabsf(x);
+        }
+
+        for (int s = 0; s < FilterBankState::SECTIONS; s++)
+        {
+            st.z1[s][lane] = z1[s];
+            st.z2[s][lane] = z2[s];
+        }
+        st.envelope[lane] = env;
+    }
+}
+
+#if defined(DSP_X86)
+
+static void filterBankSse2(FilterBankState &st, const float *samples, size_t n)
+{
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    const __m128 release = _mm_set1_ps(st.release);
+
+    for (int lane = 0; lane < st.activeLanes; lane += 4)
+    {
+        const int S = FilterBankState::SECTIONS;
+        __m128 b0[S], b1[S], b2[S], a1[S], a2[S], z1[S], z2[S];
+        for (int s = 0; s < S; s++)
+        {
+            b0[s] = _mm_load_ps(&st.b0[s][lane]);
+            b1[s] = _mm_load_ps(&st.b1[s][lane]);
+            b2[s] = _mm_load_ps(&st.b2[s][lane]);
+            a1[s] = _mm_load_ps(&st.a1[s][lane]);
+            a2[s] = _mm_load_ps(&st.a2[s][lane]);
+            z1[s] = _mm_load_ps(&st.z1[s][lane]);
+            z2[s] = _mm_load_ps(&st.z2[s][lane]);
+        }
+        __m128 env = _mm_load_ps(&st.envelope[lane]);
+
+        for (size_t i = 0; i < n; i++)
+        {
+            __m128 x = _mm_set1_ps(samples[i]);
+            for (int s = 0; s < S; s++)
+            {
+                const __m128 y = _mm_add_ps(_mm_mul_ps(b0[s], x), z1[s]);
+                z1[s] = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1[s], x), _mm_mul_ps(a1[s], y)), z2[s]);
+                z2[s] = _mm_sub_ps(_mm_mul_ps(b2[s], x), _mm_mul_ps(a2[s], y));
+                x = y;
+            }
+            env = _mm_max_ps(_mm_and_ps(x, absMask), _mm_mul_ps(env, release));
+        }
+
+        for (int s = 0; s < S; s++)
+        {
+            _mm_store_ps(&st.z1[s][lane], z1[s]);
+            _mm_store_ps(&st.z2[s][lane], z2[s]);
+        }
+        _mm_store_ps(&st.envelope[lane], env);
+    }
+}
+
+DSP_TARGET_AVX2 static void filterBankAvx2(FilterBankState &st, const float *samples, size_t n)
+{
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+    const __m256 release = _mm256_set1_ps(st.release);
+
+    for (int lane = 0; lane < st.activeLanes; lane += 8)
+    {
+        const int S = FilterBankState::SECTIONS;
+        __m256 b0[S], b1[S], b2[S], a1[S], a2[S], z1[S], z2[S];
+        for (int s = 0; s < S; s++)
+        {
+            b0[s] = _mm256_load_ps(&st.b0[s][lane]);
+            b1[s] = _mm256_load_ps(&st.b1[s][lane]);
+            b2[s] = _mm256_load_ps(&st.b2[s][lane]);
+            a1[s] = _mm256_load_ps(&st.a1[s][lane]);
+            a2[s] = _mm256_load_ps(&st.a2[s][lane]);
+            z1[s] = _mm256_load_ps(&st.z1[s][lane]);
+            z2[s] = _mm256_load_ps(&st.z2[s][lane]);
+        }
+        __m256 env = _mm256_load_ps(&st.envelope[lane]);
+
+        for (size_t i = 0; i < n; i++)
+        {
+            __m256 x = _mm256_set1_ps(samples[i]);
+            for (int s = 0; s < S; s++)
+            {
+                const __m256 y = _mm256_fmadd_ps(b0[s], x, z1[s]);
+                z1[s] = _mm256_add_ps(_mm256_fnmadd_ps(a1[s], y, _mm256_mul_ps(b1[s], x)), z2[s]);
+                z2[s] = _mm256_fnmadd_ps(a2[s], y, _mm256_mul_ps(b2[s], x));
+                x = y;
+            }
+            env = _mm256_max_ps(_mm256_and_ps(x, absMask), _mm256_mul_ps(env, release));
+        }
+
+        for (int s = 0; s < S; s++)
+        {
+            _mm256_store_ps(&st.z1[s][lane], z1[s]);
+            _mm256_store_ps(&st.z2[s][lane], z2[s]);
+        }
+        _mm256_store_ps(&st.envelope[lane], env);
+    }
+}
+
+#endif
+
+FilterBankKernel filterBankKernel(SimdLevel level)
+{
+#if defined(DSP_X86)
+    // Для 32 полос AVX-512 не даёт выигрыша над AVX2: упираемся в цепочку зависимостей
+    if (level >= SimdLevel::Avx2)
+        return filterBankAvx2;
+    if (level >= SimdLevel::Sse2)
+        return filterBankSse2;
+#else
+    (void)level;
+#endif
+    return filterBankScalar;
+}
+
+// Биквад по формулам RBJ; highPass = false — ФНЧ
+static void designBiquad(FilterBankState &st, int section, int lane, float freq, float sampleRate, bool highPass, double q)
+{
+    const double w0 = 2.0 * 3.14159265358979323846 * freq / sampleRate;
+    const double cosW = cos(w0);
+    const double alpha = sin(w0) / (2.0 * q);
+    const double a0 = 1.0 + alpha;
+
+    const double b0 = highPass ? (1.0 + cosW) / 2.0 : (1.0 - cosW) / 2.0;
+    const double b1 = highPass ? -(1.0 + cosW) : (1.0 - cosW);
+
+    st.b0[section][lane] = (float)(b0 / a0);
+    st.b1[section][lane] = (float)(b1 / a0);
+    st.b2[section][lane] = (float)(b0 / a0);
+    st.a1[section][lane] = (float)(-2.0 * cosW / a0);
+    st.a2[section][lane] = (float)((1.0 - alpha) / a0);
+}
+
+// Сквозное звено, когда граница полосы на нуле или выше Найквиста
+static void designBypass(FilterBankState &st, int section, int lane)
+{
+    st.b0[section][lane] = 1.0f;
+    st.b1[section][lane] = 0.0f;
+    st.b2[section][lane] = 0.0f;
+    st.a1[section][lane] = 0.0f;
+    st.a2[section][lane] = 0.0f;
+}
+
+FilterBankEngine::FilterBankEngine()
+{
+    memset(&state, 0, sizeof(state));
+    memset(levels, 0, sizeof(levels));
+    rebuildFilters();
+}
+
+bool FilterBankEngine::setBands(const std::vector<BandData> &newBands)
+{
+    if (newBands.size() > MAX_BANDS)
+        return false;
+    bands = newBands;
+    rebuildFilters();
+    return true;
+}
+
+void FilterBankEngine::setSampleRate(float newRate)
+{
+    rate = newRate;
+    rebuildFilters();
+}
+
+bool FilterBankEngine::setHopSize(int newHop)
+{
+    if (newHop < 1)
+        return false;
+    hop = newHop;
+    hopCounter = 0;
+    return true;
+}
+
+void FilterBankEngine::rebuildFilters()
+{
+    memset(&state, 0, sizeof(state));
+
+    // Фильтр Баттерворта порядка 2K как каскад K биквадов с добротностями
+    // 1 / (2 cos(pi (2k + 1) / 4K))
+    const int K = FILTER_BANK_SECTIONS_PER_EDGE;
+    const float nyquist = rate * 0.5f;
+    for (int lane = 0; lane < FilterBankState::LANES; lane++)
+    {
+        const bool active = lane < (int)bands.size();
+        const bool highPass = active && bands[lane].freqMin > 0.0f && bands[lane].freqMin < nyquist;
+        const bool lowPass = active && bands[lane].freqMax < nyquist * 0.95f;
+
+        for (int k = 0; k < K; k++)
+        {
+            const double q = 1.0 / (2.0 * cos(3.14159265358979323846 * (2 * k + 1) / (4.0 * K)));
+
+            if (highPass)
+                designBiquad(state, k, lane, bands[lane].freqMin, rate, true, q);
+            else
+                designBypass(state, k, lane);
+
+            if (lowPass)
+                designBiquad(state, K + k, lane, bands[lane].freqMax, rate, false, q);
+            else
+                designBypass(state, K + k, lane);
+        }
+    }
+
+    state.release = expf(-1.0f / (FILTER_BANK_RELEASE_MS * 0.001f * rate));
+    state.activeLanes = ((int)bands.size() + 7) & ~7;
+    hopCounter = 0;
+}
+
+void FilterBankEngine::process(const float *samples, size_t count, FrameSink &sink)
+{
+    while (count > 0)
+    {
+        size_t n = (size_t)(hop - hopCounter);
+        if (n > count)
+            n = count;
+
+        kernel(state, samples, n);
+
+        samples += n;
+        count -= n;
+        hopCounter += (int)n;
+
+        if (hopCounter >= hop)
+        {
+            for (size_t b = 0; b < bands.size(); b++)
+                levels[b] = bandLevel(state.envelope[b] * FILTER_BANK_LEVEL_SCALE);
+            latencyMark(LatencyStage::Bands);
+            sink.onFrame(levels, bands.size());
+            hopCounter = 0;
+        }
+    }
+}
@@ -0,0 +1,154 @@
+#include "latency_stats.h"
+#include <chrono>
+
+static LatencyHistogram histograms[(int)LatencyStage::Count];
+static thread_local FrameStamps frameStamps = {};
+
+// До 16 мкс корзины по 1 мкс, дальше 16 корзин на каждую октаву
+static int bucketOf(uint64_t us)
+{
+    if (us < LATENCY_SUB_BUCKETS)
+        return (int)us;
+
+    int msb = 4;
+    while ((us >> (msb + 1)) != 0)
+        msb++;
+    const int shift = msb - 4;
+    const int index = (shift + 1) * LATENCY_SUB_BUCKETS + (int)((us >> shift) - LATENCY_SUB_BUCKETS);
+    return index < LATENCY_BUCKETS ? index : LATENCY_BUCKETS - 1;
+}
+
+// Верхняя граница корзины в микросекундах
+static uint64_t bucketLimit(int index)
+{
+    if (index < LATENCY_SUB_BUCKETS)
+        return (uint64_t)index;
+
+    const int shift = index / LATENCY_SUB_BUCKETS - 1;
+    const uint64_t mantissa = (uint64_t)(index % LATENCY_SUB_BUCKETS + LATENCY_SUB_BUCKETS);
+    return ((mantissa + 1) << shift) - 1;
+}
+
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+void LatencyHistogram::record(uint64_t us)
+{
+    buckets[bucketOf(us)].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t seen = maxUs.load(std::memory_order_relaxed);
+    while (us > seen && !maxUs.compare_exchange_weak(seen, us, std::memory_order_relaxed))
+    {
+    }
+}
+
+uint64_t LatencyHistogram::percentile(double fraction) const
+{
+    // Корзины читаются не атомарно как целое: во время записи отчёт может
+    // разойтись с count на несколько замеров, для перцентилей это неважно
+    uint64_t total = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++)
+        total += buckets[i].load(std::memory_order_relaxed);
+    if (total == 0)
+        return 0;
+
+    // Граница корзины может оказаться выше реального максимума
+    const uint64_t maxSeen = maxUs.load(std::memory_order_relaxed);
+    const uint64_t target = (uint64_t)(fraction * total + 0.5);
+    uint64_t seen = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++)
+    {
+        seen += buckets[i].load(std::memory_order_relaxed);
+        if (seen >= target && seen > 0)
+            return bucketLimit(i) < maxSeen ? bucketLimit(i) : maxSeen;
+    }
+    return maxSeen;
+}
+
+void LatencyHistogram::reset()
+{
+    for (int i = 0; i < LATENCY_BUCKETS; i++)
+        buckets[i].store(0, std::memory_order_relaxed);
+    count.store(0, std::memory_order_relaxed);
+    maxUs.store(0, std::memory_order_relaxed);
+}
+
+uint64_t latencyNow()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void latencyMark(LatencyStage stage)
+{
+    frameStamps.at[(int)stage] = latencyNow();
+}
+
+FrameStamps &currentFrameStamps()
+{
+    return frameStamps;
+}
+
+void latencyRecord(const FrameStamps &stamps)
+{
+    // Без времени захвата (пакетный режим, потерянная метка) кадр не учитывается
+    if (stamps.origin == 0)
+        return;
+
+    for (int s = 0; s < (int)LatencyStage::Count; s++)
+    {
+        const uint64_t at = stamps.at[s];
+        if (at >= stamps.origin)
+            histograms[s].record((at - stamps.origin) / 1000);
+    }
+}
+
+void latencyCommitFrame()
+{
+    latencyRecord(frameStamps);
+
+    // Время захвата остаётся: следующий кадр того же куска считается от него же
+    for (int s = 0; s < (int)LatencyStage::Count; s++)
+        frameStamps.at[s] = 0;
+}
+
+const char *latencyStageName(LatencyStage stage)
+{
+    switch (stage)
+    {
+    case LatencyStage::Capture:
+        return "capture";
+    case LatencyStage::Window:
+        return "window";
+    case LatencyStage::Fft:
+        return "fft";
+    case LatencyStage::Bands:
+        return "bands";
+    case LatencyStage::Handoff:
+        return "handoff";
+    case LatencyStage::WriteDone:
+        return "write-done";
+    default:
+        return "?";
+    }
+}
+
+void printLatencyReport(FILE *out, bool reset)
+{
+    fprintf(out, "\nlatency from capture, us      count       p50       p99       max\n");
+    for (int s = 0; s < (int)LatencyStage::Count; s++)
+    {
+        LatencyHistogram &h = histograms[s];
+        fprintf(out, "%-24s %10llu %9llu %9llu %9llu\n", latencyStageName((LatencyStage)s),
+                (unsigned long long)h.count.load(std::memory_order_relaxed),
+                (unsigned long long)h.percentile(0.50), (unsigned long long)h.percentile(0.99),
+                (unsigned long long)h.maxUs.load(std::memory_order_relaxed));
+        if (reset)
+            h.reset();
+    }
+    fflush(out);
+}
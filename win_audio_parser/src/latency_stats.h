@@ -0,0 +1,59 @@
+// Задержка от прихода сэмпла в data_callback до каждой стадии конвейера.
+// Гистограммы без блокировок: писатели только атомарно увеличивают счётчики,
+// отчёт можно снять из любого потока в любой момент.
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+
+enum class LatencyStage
+{
+    Capture,   // Сэмплы забраны из кольца потоком анализа
+    Window,    // Окно наложено
+    Fft,       // FFT посчитан
+    Bands,     // Яркости полос квантованы
+    Handoff,   // Кадр отдан передатчику
+    WriteDone, // Запись в порт завершилась
+    Count,
+};
+
+// 16 корзин на октаву: погрешность перцентиля не больше 1/16
+#define LATENCY_SUB_BUCKETS 16
+#define LATENCY_BUCKETS 512
+
+struct LatencyHistogram
+{
+    std::atomic<uint32_t> buckets[LATENCY_BUCKETS];
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> maxUs{0};
+
+    LatencyHistogram();
+
+    void record(uint64_t us);
+    // Значение в микросекундах, ниже которого лежит доля fraction замеров
+    uint64_t percentile(double fraction) const;
+    void reset();
+};
+
+// Монотонное время в наносекундах
+uint64_t latencyNow();
+
+// Отметки кадра в потоке анализа: origin — время прихода самого нового
+// сэмпла кадра, at[] — моменты стадий (0 — стадия в этом кадре не проходилась)
+struct FrameStamps
+{
+    uint64_t origin;
+    uint64_t at[(int)LatencyStage::Count];
+};
+
+// Движки ставят отметки в кадр текущего потока; стоит одно чтение часов
+void latencyMark(LatencyStage stage);
+FrameStamps &currentFrameStamps();
+// Переносит отметки кадра текущего потока в гистограммы и очищает их
+void latencyCommitFrame();
+// Для кадров, отметки которых уехали в другой поток вместе с кадром
+void latencyRecord(const FrameStamps &stamps);
+
+const char *latencyStageName(LatencyStage stage);
+// Таблица count / p50 / p99 / max по стадиям; reset обнуляет гистограммы после вывода
+void printLatencyReport(FILE *out, bool reset);
@@ -0,0 +1,45 @@
+// Почтовый ящик на одно значение без блокировок: писатель всегда кладёт
+// свежее значение, читатель всегда забирает самое последнее. Непрочитанное
+// значение вытесняется. Тройная буферизация: у писателя и читателя по своему
+// слоту, третий — «в ящике»; слоты меняются одним atomic exchange.
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+template <typename T>
+class LatestMailbox
+{
+public:
+    LatestMailbox() = default;
+    LatestMailbox(const LatestMailbox &) = delete;
+    LatestMailbox &operator=(const LatestMailbox &) = delete;
+
+    // Вызывается только писателем. true — предыдущее значение никто не забрал
+    bool publish(const T &value)
+    {
+        slots[back] = value;
+        const uint8_t previous = middle.exchange((uint8_t)(back | FRESH), std::memory_order_acq_rel);
+        back = previous & INDEX;
+        return (previous & FRESH) != 0;
+    }
+
+    // Вызывается только читателем. false — нового значения нет
+    bool take(T &out)
+    {
+        if ((middle.load(std::memory_order_relaxed) & FRESH) == 0)
+            return false;
+        const uint8_t previous = middle.exchange(front, std::memory_order_acq_rel);
+        front = previous & INDEX;
+        out = slots[front];
+        return true;
+    }
+
+private:
+    static constexpr uint8_t INDEX = 0x03;
+    static constexpr uint8_t FRESH = 0x04;
+
+    T slots[3];
+    uint8_t back = 0;                     // Слот писателя
+    uint8_t front = 1;                    // Слот читателя
+    alignas(64) std::atomic<uint8_t> middle{2}; // Слот в ящике и флаг свежести
+};
@@ -0,0 +1,51 @@
+// Кадр яркостей для Arduino: протокол v2 из shared_protocol.h (COBS, номер кадра,
+// формат данных, CRC-16)
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "band_map.h"
+#include "shared_protocol.h"
+
+#define MAX_PACKET_SIZE PROTOCOL_MAX_FRAME
+// Полный кадр раз в 32 кадра: после потери дельты картинка восстанавливается
+// за ~0.4 с при 86 кадрах/с
+#define DEFAULT_KEYFRAME_INTERVAL 32
+
+static_assert(MAX_BANDS <= PROTOCOL_MAX_CHANNELS, "protocol frame must fit all bands");
+
+// raw, nibble, delta или delta-nibble
+inline bool parseProtocolFormat(const char *name, uint8_t *out)
+{
+    if (strcmp(name, "raw") == 0)
+        *out = 0;
+    else if (strcmp(name, "nibble") == 0)
+        *out = PROTOCOL_NIBBLE;
+    else if (strcmp(name, "delta") == 0)
+        *out = PROTOCOL_DELTA;
+    else if (strcmp(name, "delta-nibble") == 0)
+        *out = PROTOCOL_DELTA | PROTOCOL_NIBBLE;
+    else
+        return false;
+    return true;
+}
+
+// linear, gamma или cie — кривая яркости на плате
+inline bool parseBrightnessCurve(const char *name, uint8_t *out)
+{
+    if (strcmp(name, "linear") == 0)
+        *out = PROTOCOL_CURVE_LINEAR;
+    else if (strcmp(name, "gamma") == 0)
+        *out = PROTOCOL_CURVE_GAMMA;
+    else if (strcmp(name, "cie") == 0)
+        *out = PROTOCOL_CURVE_CIE;
+    else
+        return false;
+    return true;
+}
+
+// packet — буфер на MAX_PACKET_SIZE байт; возвращает длину пакета вместе с разделителем
+inline size_t encodeLevelsPacket(ProtocolEncoder *encoder, const uint8_t *levels, size_t count, uint8_t *packet)
+{
+    return protocolEncodeLevels(encoder, levels, (uint8_t)count, packet);
+}
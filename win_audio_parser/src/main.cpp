@@ -2,183 +2,449 @@
 #include "miniaudio.h"
 #include <iostream>
 #include <vector>
-#include <windows.h>
+#ifdef _WIN32
+#include <windows.h> // timeBeginPeriod
+#endif
 #include <cmath>
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iomanip>
+#include <string>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
 #include "shared_protocol.h"
-extern "C"
+#include "alloc_guard.h"
+#include "audio_dsp.h"
+#include "band_engine.h"
+#include "baud_negotiation.h"
+#include "batch_analysis.h"
+#include "board_control.h"
+#include "cpu_features.h"
+#include "downmix.h"
+#include "engine_options.h"
+#include "fft_backend.h"
+#include "latency_stats.h"
+#include "level_packet.h"
+#include "serial_transport.h"
+#include "serial_writer.h"
+#include "spsc_ring.h"
+#include "window_tables.h"
+
+std::unique_ptr<SerialTransport> serialPort;
+
+// Вызывается только из потока передатчика; без порта пакеты считаются потерянными
+bool writeSerial(const uint8_t *data, size_t size)
 {
-#include "kiss_fftr.h"
+    return serialPort && serialPort->write(data, size);
 }
 
-#define FFT_SIZE 4096 // Размер окна (степень двойки)
-// #define FFT_SIZE 2048 // Размер окна (степень двойки)
-
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
+// Примерно 1.5 секунды звука при 44.1 кГц: запас на случай, если DSP-поток задержится
+#define CAPTURE_RING_SIZE (1 << 16)
+// Сколько сэмплов DSP-поток забирает из кольца за один раз
+#define DSP_READ_CHUNK 1024
+// Меток времени захвата: по одной на вызов data_callback, ~10 с при 10 мс на вызов
+#define CAPTURE_MARK_RING_SIZE 1024
+// Драйвер после смены частоты микшера может быть ещё занят: столько попыток
+// переоткрыть устройство с такой паузой между ними
+#define CAPTURE_REOPEN_ATTEMPTS 5
+#define CAPTURE_REOPEN_RETRY_MS 200
+
+// Когда пришёл блок захвата: end — номер сэмпла сразу за блоком
+struct CaptureMark
+{
+    uint64_t end;
+    uint64_t time;
+};
 
-HANDLE hSerial;
+// Всё, что нужно аудиопотоку: по кольцу на анализируемый канал и рабочие буферы
+struct CaptureState
+{
+    DownmixMode mode = DownmixMode::Mid;
+    DownmixKernel downmix = nullptr;
+    DeinterleaveKernel deinterleave = nullptr;
+    int ringCount = 0;
+    SpscRing<float> *rings[MAX_CAPTURE_CHANNELS];
+    // Новая родная частота устройства после переключения микшера, 0 — без изменений
+    std::atomic<ma_uint32> nativeRate{0};
+    float scratch[MAX_CAPTURE_CHANNELS][DOWNMIX_BLOCK];
+
+    // По меткам поток анализа находит время прихода сэмплов каждого кадра
+    SpscRing<CaptureMark> marks{CAPTURE_MARK_RING_SIZE};
+    uint64_t samplesWritten = 0; // Только аудиопоток; сэмплов в кольце каждого канала
+};
 
-bool initSerial(const char *portName)
+// Аудиопоток только сводит каналы и копирует сэмплы в кольца: никакой математики, вывода и WriteFile
+void data_callback(ma_device *pDevice, void *pOutput, const void *pInput, ma_uint32 frameCount)
 {
-    hSerial = CreateFileA(portName, GENERIC_WRITE, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
-    if (hSerial == INVALID_HANDLE_VALUE)
-        return false;
-
-    DCB dcbSerialParams = {0};
-    dcbSerialParams.DCBlength = sizeof(dcbSerialParams);
-    GetCommState(hSerial, &dcbSerialParams);
-    dcbSerialParams.BaudRate = CBR_115200;
-    dcbSerialParams.ByteSize = 8;
-    dcbSerialParams.StopBits = ONESTOPBIT;
-    dcbSerialParams.Parity = NOPARITY;
-    return SetCommState(hSerial, &dcbSerialParams);
+    CaptureState *capture = (CaptureState *)pDevice->pUserData;
+    const float *pIn = (const float *)pInput;
+
+    if (pIn == NULL)
+        return;
+
+    allocGuardArm();
+    const uint64_t arrived = latencyNow();
+
+    const int channels = (int)pDevice->capture.channels;
+    float *outs[MAX_CAPTURE_CHANNELS];
+    for (int c = 0; c < capture->ringCount; c++)
+        outs[c] = capture->scratch[c];
+
+    // Буфер устройства проходит блоками, чтобы рабочие массивы имели фиксированный размер
+    while (frameCount > 0)
+    {
+        const size_t n = frameCount < DOWNMIX_BLOCK ? frameCount : DOWNMIX_BLOCK;
+
+        if (capture->mode == DownmixMode::Split)
+            capture->deinterleave(pIn, n, channels, outs, capture->ringCount);
+        else
+            capture->downmix(pIn, n, channels, outs[0]);
+
+        // Во все кольца пишется поровну, счёт ведём по первому
+        capture->samplesWritten += capture->rings[0]->write(outs[0], n);
+        for (int c = 1; c < capture->ringCount; c++)
+            capture->rings[c]->write(outs[c], n);
+
+        pIn += n * channels;
+        frameCount -= (ma_uint32)n;
+    }
+
+    const CaptureMark mark = {capture->samplesWritten, arrived};
+    capture->marks.write(&mark, 1);
 }
 
-struct BandData
+// Последний кадр для строки состояния. DSP-поток только кладёт уровни,
+// печатает главный поток раз в 100 мс: вывод в консоль может блокироваться.
+// Кадр целиком не атомарен — строка может смешать два соседних кадра
+struct StatusLevels
 {
-    float freqMin;
-    float freqMax;
-    float multiplier; // Теперь работает как коэффициент чувствительности в дБ
-    uint8_t currentVal = 0;
+    std::atomic<uint8_t> levels[MAX_BANDS];
+    std::atomic<size_t> count{0};
 };
 
-struct AudioDSP
+// Готовый кадр уходит в порт и в строку состояния консоли
+struct SerialSink : FrameSink
 {
-    std::vector<BandData> bands;
-    kiss_fftr_cfg fftConfig;
-    float fftInput[FFT_SIZE];
-    kiss_fft_cpx fftOutput[FFT_SIZE / 2 + 1];
-    int sampleCounter = 0;
-    float sampleRate = 44100.0f;
-
-    AudioDSP()
-    {
-        fftConfig = kiss_fftr_alloc(FFT_SIZE, 0, NULL, NULL);
-        memset(fftInput, 0, sizeof(fftInput));
-    }
+    SerialWriter *writer;
+    StatusLevels *status;
+
+    // Рабочий буфер заведён заранее: в горячем пути нет ни одного new
+    LevelFrame frame;
 
-    ~AudioDSP()
+    SerialSink(SerialWriter *serialWriter, StatusLevels *statusLevels) : writer(serialWriter), status(statusLevels) {}
+
+    void onFrame(const uint8_t *levels, size_t count) override
     {
-        kiss_fftr_free(fftConfig);
+        const bool hasSignal = std::any_of(levels, levels + count, [](uint8_t level)
+                                           { return level > 0; });
+
+        if (hasSignal)
+        {
+            // Отметки задержки уходят вместе с кадром: запись завершит передатчик
+            latencyMark(LatencyStage::Handoff);
+            frame.count = count;
+            memcpy(frame.levels, levels, count);
+            frame.stamps = currentFrameStamps();
+            writer->publish(frame);
+            for (uint64_t &at : currentFrameStamps().at)
+                at = 0;
+        }
+        else
+            latencyCommitFrame();
+
+        for (size_t b = 0; b < count; ++b)
+            status->levels[b].store(levels[b], std::memory_order_relaxed);
+        status->count.store(count, std::memory_order_relaxed);
     }
 };
 
-void sendPacket(const std::vector<BandData> &bands)
+// Строка состояния собирается в своём буфере и печатается одним fputs
+static void printStatusLine(const StatusLevels &status, const SpscRing<float> *ring, const SerialWriter &writer)
 {
-    std::vector<uint8_t> packet;
-    packet.push_back(0xFE);
-    for (const auto &band : bands)
+    char line[160 + MAX_BANDS * 16];
+    const size_t lineSize = sizeof(line);
+    const size_t count = status.count.load(std::memory_order_relaxed);
+    int len = snprintf(line, lineSize, "\r");
+    for (size_t b = 0; b < count; ++b)
     {
-        packet.push_back(band.currentVal);
+        len += snprintf(line + len, lineSize - len, " | CH%zu: %3d", b + 1, (int)status.levels[b].load(std::memory_order_relaxed));
     }
-    DWORD written;
-    WriteFile(hSerial, packet.data(), (DWORD)packet.size(), &written, NULL);
+    const uint64_t sent = writer.sent();
+    snprintf(line + len, lineSize - len, " | overruns: %llu (%llu samples) | sent %llu (%.1f B), coalesced %llu, failed %llu    ",
+             (unsigned long long)ring->overruns(), (unsigned long long)ring->dropped(),
+             (unsigned long long)sent, sent ? (double)writer.bytes() / sent : 0.0,
+             (unsigned long long)writer.coalesced(), (unsigned long long)writer.failed());
+    fputs(line, stdout);
+    fflush(stdout);
 }
 
-void data_callback(ma_device *pDevice, void *pOutput, const void *pInput, ma_uint32 frameCount)
+// Склеивает кадры раздельно анализируемых каналов в один пакет:
+// сначала все полосы первого канала, затем второго и т.д.
+struct ChannelMerger
 {
-    AudioDSP *dsp = (AudioDSP *)pDevice->pUserData;
-    float *pIn = (float *)pInput;
-
-    if (pIn == NULL)
-        return;
-
-    for (ma_uint32 i = 0; i < frameCount; i++)
+    struct Input : FrameSink
     {
-        dsp->fftInput[dsp->sampleCounter] = pIn[i * pDevice->capture.channels];
-        dsp->sampleCounter++;
+        ChannelMerger *owner;
+        int channel;
 
-        if (dsp->sampleCounter >= FFT_SIZE)
+        void onFrame(const uint8_t *levels, size_t count) override
         {
-            // 1. Окно Ханна (убирает шумы на соседних каналах)
-            for (int j = 0; j < FFT_SIZE; j++)
-            {
-                float window = 0.5f * (1.0f - cosf(2.0f * (float)M_PI * j / (FFT_SIZE - 1)));
-                dsp->fftInput[j] *= window;
-            }
-
-            kiss_fftr(dsp->fftConfig, dsp->fftInput, dsp->fftOutput);
+            memcpy(owner->levels + channel * count, levels, count);
+            // Движки каналов идут в ногу, последний канал закрывает кадр
+            if (channel == owner->channels - 1)
+                owner->out->onFrame(owner->levels, owner->channels * count);
+        }
+    };
 
-            std::vector<float> bandMax(dsp->bands.size(), 0.0f);
+    FrameSink *out;
+    int channels;
+    Input inputs[MAX_CAPTURE_CHANNELS];
+    uint8_t levels[MAX_BANDS];
 
-            for (int bin = 0; bin <= FFT_SIZE / 2; bin++)
-            {
-                float freq = bin * (dsp->sampleRate / (float)FFT_SIZE);
-                float r = dsp->fftOutput[bin].r;
-                float im = dsp->fftOutput[bin].i;
-
-                // Амплитуда (нормализованная)
-                float magnitude = sqrtf(r * r + im * im) / (FFT_SIZE / 2.0f);
-
-                for (size_t b = 0; b < dsp->bands.size(); b++)
-                {
-                    if (freq >= dsp->bands[b].freqMin && freq < dsp->bands[b].freqMax)
-                    {
-                        if (magnitude > bandMax[b])
-                            bandMax[b] = magnitude;
-                    }
-                }
-            }
-
-            // 2. Логарифмическая обработка (дБ)
-            for (size_t b = 0; b < dsp->bands.size(); b++)
-            {
-                // Перевод в децибелы (magnitude 1.0 = 0dB, 0.01 = -40dB)
-                float db = 20.0f * log10f(bandMax[b] + 1e-6f);
+    ChannelMerger(FrameSink *sink, int channelCount) : out(sink), channels(channelCount)
+    {
+        for (int c = 0; c < MAX_CAPTURE_CHANNELS; c++)
+        {
+            inputs[c].owner = this;
+            inputs[c].channel = c;
+        }
+        memset(levels, 0, sizeof(levels));
+    }
+};
 
-                // Настройки диапазона:
-                // minDb - уровень полной темноты (шум покоя)
-                // maxDb - уровень максимальной яркости (пик)
-                float minDb = -50.0f;
-                float maxDb = 0.0f;
-                // float maxDb = -15.0f / dsp->bands[b].multiplier;
+// Поток анализа: разбирает кольца и гоняет весь конвейер движков полос
+void dspThread(std::vector<std::unique_ptr<BandEngine>> *engines, CaptureState *capture, SerialWriter *writer,
+               StatusLevels *status, const std::atomic<bool> *running)
+{
+    static float chunk[MAX_CAPTURE_CHANNELS][DSP_READ_CHUNK];
+    const int channels = capture->ringCount;
+    SerialSink sink(writer, status);
+    ChannelMerger merger(&sink, channels);
+    enableFlushToZero();
+    allocGuardArm();
 
-                // Линейная интерполяция дБ в диапазон 0..1
-                float normalized = (db - minDb) / (maxDb - minDb);
+    // Кусками не длиннее шага каждый движок выдаёт не больше одного кадра,
+    // поэтому кадры каналов приходят в слияние парами
+    const size_t step = (size_t)(*engines)[0]->hopSize();
 
-                if (normalized < 0.0f)
-                    normalized = 0.0f;
-                if (normalized > 1.0f)
-                    normalized = 1.0f;
+    uint64_t samplesRead = 0;
+    CaptureMark mark = {0, 0};
 
-                dsp->bands[b].currentVal = (uint8_t)(normalized * 255.0f);
-            }
+    while (running->load(std::memory_order_relaxed))
+    {
+        // Аудиопоток пишет во все кольца поровну, но читаем по самому отстающему
+        size_t count = DSP_READ_CHUNK;
+        for (int c = 0; c < channels; c++)
+            count = std::min(count, capture->rings[c]->available());
+        if (count == 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
 
-            const bool hasSignal = std::any_of(dsp->bands.begin(), dsp->bands.end(), [](const auto &item)
-                                               { return item.currentVal > 0; });
+        for (int c = 0; c < channels; c++)
+            capture->rings[c]->read(chunk[c], count);
+        const uint64_t pickedUp = latencyNow();
 
-            if (hasSignal)
-                sendPacket(dsp->bands);
+        for (size_t offset = 0; offset < count; offset += step)
+        {
+            const size_t n = std::min(step, count - offset);
 
-            std::cout << "\r";
-            for (size_t b = 0; b < dsp->bands.size(); ++b)
+            // Кадр, если он выйдет из этого куска, кончается не позже последнего
+            // сэмпла куска: его время прихода и берём за начало отсчёта
+            // (погрешность — не больше одного блока захвата)
+            const uint64_t last = samplesRead + offset + n;
+            while (mark.end < last && capture->marks.read(&mark, 1) == 1)
             {
-                std::cout << " | CH" << (b + 1) << ": " << std::setw(3) << (int)dsp->bands[b].currentVal;
             }
-            std::cout << "    " << std::flush;
+            FrameStamps &stamps = currentFrameStamps();
+            stamps.origin = mark.end >= last ? mark.time : 0;
+            stamps.at[(int)LatencyStage::Capture] = pickedUp;
 
-            dsp->sampleCounter = 0;
+            for (int c = 0; c < channels; c++)
+                (*engines)[c]->process(chunk[c] + offset, n, merger.inputs[c]);
         }
+        samplesRead += count;
     }
 }
 
-int main()
+// WASAPI переоткрывает устройство при смене формата микшера; если родная
+// частота уже не совпадает с нашей, просим главный поток переоткрыть захват
+void notification_callback(const ma_device_notification *pNotification)
+{
+    if (pNotification->type != ma_device_notification_type_rerouted)
+        return;
+
+    ma_device *pDevice = pNotification->pDevice;
+    CaptureState *capture = (CaptureState *)pDevice->pUserData;
+    if (pDevice->capture.internalSampleRate != pDevice->sampleRate)
+        capture->nativeRate = pDevice->capture.internalSampleRate;
+}
+
+// Захват открывается на родной частоте микшера: sampleRate = 0 и запрет
+// преобразования внутри WASAPI убирают ресемплер из тракта целиком.
+// channels = 0 — родная раскладка устройства, сведение делаем сами.
+// Loopback есть только в WASAPI; на Linux пишем вход по умолчанию — в нём
+// выбирают монитор выхода (pavucontrol, pw-link)
+bool openCapture(ma_device *device, CaptureState *capture, ma_uint32 channels)
+{
+    // Формат захвата задаётся в capture: поля playback для loopback игнорируются
+#ifdef _WIN32
+    ma_device_config config = ma_device_config_init(ma_device_type_loopback);
+#else
+    ma_device_config config = ma_device_config_init(ma_device_type_capture);
+#endif
+    config.capture.format = ma_format_f32;
+    config.capture.channels = channels;
+    config.sampleRate = 0;
+    config.wasapi.noAutoConvertSRC = MA_TRUE;
+    config.dataCallback = data_callback;
+    config.notificationCallback = notification_callback;
+    config.pUserData = capture;
+
+    return ma_device_init(NULL, &config, device) == MA_SUCCESS;
+}
+
+// Все частотные таблицы (бины полос, фильтры, группы) пересчитываются движками
+void applySampleRate(std::vector<std::unique_ptr<BandEngine>> &engines, float rate)
+{
+    for (auto &engine : engines)
+        engine->setSampleRate(rate);
+}
+
+int main(int argc, char **argv)
 {
     std::cout << "--- Multi-Band FFT Visualizer (Logarithmic) ---" << std::endl;
 
-    if (!initSerial("\\\\.\\COM3"))
+    EngineOptions options;
+    DownmixMode downmixMode = DownmixMode::Mid;
+    bool batchMode = false;
+    BatchOptions batch;
+    int latencyPeriod = 0; // Секунд между отчётами о задержках; 0 — только по запросу
+    const char *portPath = SERIAL_DEFAULT_PORT;
+    int baud = SERIAL_DEFAULT_BAUD;
+    int maxBaud = NEGOTIATION_DEFAULT_MAX_BAUD;
+    bool usePty = false;
+    uint8_t protocolFormat = PROTOCOL_DELTA;
+    int keyframeInterval = DEFAULT_KEYFRAME_INTERVAL;
+    int brightnessCurve = -1; // -1 — оставить кривую, с которой собрана прошивка
+    for (int i = 1; i < argc; i++)
     {
-        std::cerr << "Error: Could not open Arduino port." << std::endl;
+        if (strcmp(argv[i], "--fft") == 0 && i + 1 < argc)
+            options.fftSize = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--hop") == 0 && i + 1 < argc)
+            options.hopSize = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--multires") == 0)
+            options.multiResolution = true;
+        else if (strcmp(argv[i], "--decimate") == 0 && i + 1 < argc)
+        {
+            // Прореживание имеет смысл только для басового анализатора многоразрешающего режима
+            options.decimation = atoi(argv[++i]);
+            options.multiResolution = true;
+        }
+        else if (strcmp(argv[i], "--bass-fft") == 0 && i + 1 < argc)
+        {
+            // Разрешение басового анализатора после дециматора; не больше --fft
+            options.bassFftSize = atoi(argv[++i]);
+            options.multiResolution = true;
+        }
+        else if (strcmp(argv[i], "--engine") == 0 && i + 1 < argc)
+        {
+            const char *name = argv[++i];
+            if (strcmp(name, "iir") == 0)
+                options.filterBank = true;
+            else if (strcmp(name, "fft") != 0)
+            {
+                std::cerr << "Error: engine must be fft or iir" << std::endl;
+                return -1;
+            }
+        }
+        else if (strcmp(argv[i], "--window") == 0 && i + 1 < argc)
+        {
+            if (!parseWindowType(argv[++i], &options.windowType))
+            {
+                std::cerr << "Error: window must be hann, blackman-harris, flattop or kaiser" << std::endl;
+                return -1;
+            }
+        }
+        else if (strcmp(argv[i], "--downmix") == 0 && i + 1 < argc)
+        {
+            if (!parseDownmixMode(argv[++i], &downmixMode))
+            {
+                std::cerr << "Error: downmix must be mid, side, max or split" << std::endl;
+                return -1;
+            }
+        }
+        else if (strcmp(argv[i], "--fft-backend") == 0 && i + 1 < argc)
+        {
+            FftBackendType backend;
+            if (!parseFftBackend(argv[++i], &backend))
+            {
+                std::cerr << "Error: FFT backend must be " << (fftBackendAvailable(FftBackendType::Kiss) ? "kiss, " : "")
+                          << "radix4, split-radix or auto" << std::endl;
+                return -1;
+            }
+            setDefaultFftBackend(backend);
+        }
+        else if (strcmp(argv[i], "--latency") == 0 && i + 1 < argc)
+            latencyPeriod = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc)
+            portPath = argv[++i];
+        else if (strcmp(argv[i], "--baud") == 0 && i + 1 < argc)
+            baud = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--max-baud") == 0 && i + 1 < argc)
+            maxBaud = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--encoding") == 0 && i + 1 < argc)
+        {
+            if (!parseProtocolFormat(argv[++i], &protocolFormat))
+            {
+                std::cerr << "Error: encoding must be raw, nibble, delta or delta-nibble" << std::endl;
+                return -1;
+            }
+        }
+        else if (strcmp(argv[i], "--keyframe") == 0 && i + 1 < argc)
+        {
+            keyframeInterval = atoi(argv[++i]);
+            if (keyframeInterval < 0 || keyframeInterval > 255)
+            {
+                std::cerr << "Error: keyframe interval must be in 0..255" << std::endl;
+                return -1;
+            }
+        }
+        else if (strcmp(argv[i], "--curve") == 0 && i + 1 < argc)
+        {
+            uint8_t curve = 0;
+            if (!parseBrightnessCurve(argv[++i], &curve))
+            {
+                std::cerr << "Error: curve must be linear, gamma or cie" << std::endl;
+                return -1;
+            }
+            brightnessCurve = curve;
+        }
+        else if (strcmp(argv[i], "--pty") == 0)
+        {
+#ifdef _WIN32
+            std::cerr << "Error: --pty needs a POSIX system" << std::endl;
+            return -1;
+#else
+            usePty = true;
+#endif
+        }
+        else if (strcmp(argv[i], "--batch") == 0)
+            batchMode = true;
+        else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+            batch.outDir = argv[++i];
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            batch.threads = atoi(argv[++i]);
+        else if (strncmp(argv[i], "--", 2) != 0)
+            batch.files.push_back(argv[i]);
     }
 
-    Sleep(2000);
-    AudioDSP dsp;
-
-    dsp.bands = {
+    const std::vector<BandData> bands = {
         {0.0f, 150.0f, 1.0f},
         {150.0f, 400.0f, 1.0f},
         {400.0f, 1500.0f, 1.0f},
@@ -186,25 +452,193 @@ int main()
         {4000.0f, 8000.0f, 1.0f},
         {8000.0f, 22000.0f, 1.0f}};
 
-    ma_device_config config = ma_device_config_init(ma_device_type_loopback);
-    config.playback.format = ma_format_f32;
-    config.playback.channels = 1;
-    config.sampleRate = (ma_uint32)dsp.sampleRate;
-    config.dataCallback = data_callback;
-    config.pUserData = &dsp;
+    // Пакетный режим: ни порта, ни устройства захвата
+    if (batchMode)
+    {
+        if (batch.files.empty())
+        {
+            std::cerr << "Error: --batch needs at least one audio file" << std::endl;
+            return -1;
+        }
+        batch.downmix = downmixMode;
+        return runBatch(batch, options, bands) == 0 ? 0 : 1;
+    }
 
-    ma_device device;
-    if (ma_device_init(NULL, &config, &device) != MA_SUCCESS)
+    std::vector<std::unique_ptr<BandEngine>> engines;
+    engines.push_back(makeEngine(options));
+    if (!engines[0])
+        return -1;
+    BandEngine *engine = engines[0].get();
+
+#ifndef _WIN32
+    if (usePty)
+        serialPort = openPtyTransport();
+    else
+#endif
     {
-        CloseHandle(hSerial);
+        serialPort = openSerialPort(portPath, baud);
+        if (!serialPort)
+            std::cerr << "Error: Could not open Arduino port." << std::endl;
+        // Открытие порта дёргает DTR и перезагружает Arduino: ждём загрузчик
+        std::this_thread::sleep_for(std::chrono::seconds(2));
+    }
+    // --max-baud не выше --baud отключает согласование
+    if (serialPort && maxBaud > baud)
+        baud = negotiateBaud(*serialPort, baud, maxBaud);
+    if (serialPort && brightnessCurve >= 0 && !requestBrightnessCurve(*serialPort, (uint8_t)brightnessCurve))
+        std::cout << "Board did not confirm the brightness curve" << std::endl;
+
+    engine->setBands(bands);
+
+    std::unique_ptr<CaptureState> capture(new CaptureState());
+
+    ma_device device;
+    if (!openCapture(&device, capture.get(), 0))
         return -1;
+
+    // Раздельный анализ ограничен тем, сколько полос влезает в один пакет
+    const SimdLevel simd = detectSimdLevel();
+    const int deviceChannels = (int)device.capture.channels;
+    int analysisChannels = 1;
+    if (downmixMode == DownmixMode::Split)
+        analysisChannels = std::min(std::min(deviceChannels, MAX_CAPTURE_CHANNELS), (int)(MAX_BANDS / bands.size()));
+    while ((int)engines.size() < analysisChannels)
+    {
+        engines.push_back(makeEngine(options));
+        engines.back()->setBands(bands);
     }
+    applySampleRate(engines, (float)device.sampleRate);
+
+    std::vector<std::unique_ptr<SpscRing<float>>> rings;
+    for (int c = 0; c < analysisChannels; c++)
+    {
+        rings.emplace_back(new SpscRing<float>(CAPTURE_RING_SIZE));
+        capture->rings[c] = rings.back().get();
+    }
+    capture->ringCount = analysisChannels;
+    capture->mode = downmixMode;
+    capture->downmix = downmixKernel(downmixMode, simd);
+    capture->deinterleave = deinterleaveKernel(simd);
+
+    if (options.filterBank)
+        std::cout << "IIR filter bank";
+    else
+    {
+        std::cout << (options.multiResolution ? "Multi-resolution FFT up to " : "FFT ") << engine->fftSize()
+                  << " (" << engine->backendName() << ")";
+        if (options.decimation > 1)
+        {
+            std::cout << ", bass decimated x" << options.decimation;
+            if (options.bassFftSize > 0)
+                std::cout << " (FFT >= " << options.bassFftSize << ")";
+        }
+    }
+    std::cout << ", hop " << engine->hopSize() << " (~"
+              << std::setprecision(3) << engine->sampleRate() / engine->hopSize() << " frames/s), "
+              << simdLevelName(simd) << " kernels" << std::endl;
+    std::cout << deviceChannels << " capture channels at " << device.sampleRate << " Hz, "
+              << (downmixMode == DownmixMode::Split ? "analysed separately: " : "downmixed to mono: ")
+              << analysisChannels << " x " << bands.size() << " bands" << std::endl;
+
+#ifdef _WIN32
+    // Без этого sleep_for(1 мс) в DSP-потоке спит по ~15 мс
+    timeBeginPeriod(1);
+#endif
+
+    // Порт пишет свой поток: зависание драйвера не останавливает анализ
+    SerialWriter writer(writeSerial);
+    writer.setFormat(protocolFormat, (uint8_t)keyframeInterval);
+    writer.start();
+
+    StatusLevels status;
+    std::atomic<bool> running{true};
+    std::thread analysis(dspThread, &engines, capture.get(), &writer, &status, &running);
 
     ma_device_start(&device);
-    std::cout << "\nStreaming FFT bands to Arduino... Press Enter to stop." << std::endl;
-    std::cin.get();
+    std::cout << "\nStreaming FFT bands to Arduino... Press Enter to stop, l + Enter for latency report." << std::endl;
+
+    // Ввод ждём в отдельном потоке: главный следит за сменой частоты микшера
+    // и печатает отчёты о задержках. Флаги статические: при потере устройства
+    // поток отпускается и может пережить выход из main
+    static std::atomic<bool> stopRequested{false};
+    static std::atomic<bool> reportRequested{false};
+    std::thread input([]
+                      {
+        std::string line;
+        while (std::getline(std::cin, line) && line == "l")
+            reportRequested = true;
+        stopRequested = true; });
+
+    bool deviceOpen = true;
+    bool deviceLost = false;
+    auto nextReport = std::chrono::steady_clock::now() + std::chrono::seconds(latencyPeriod);
+    while (!stopRequested)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        printStatusLine(status, capture->rings[0], writer);
+
+        // По запросу — накопленное с прошлого периодического отчёта,
+        // периодический отчёт показывает только свой интервал
+        if (reportRequested.exchange(false))
+            printLatencyReport(stdout, false);
+        if (latencyPeriod > 0 && std::chrono::steady_clock::now() >= nextReport)
+        {
+            printLatencyReport(stdout, true);
+            nextReport += std::chrono::seconds(latencyPeriod);
+        }
+
+        const ma_uint32 newRate = capture->nativeRate.exchange(0);
+        if (newRate == 0)
+            continue;
+
+        // Переоткрываем устройство на новой родной частоте и пересчитываем таблицы.
+        // Раскладку каналов фиксируем прежней, чтобы не менять число колец.
+        ma_device_uninit(&device);
+        deviceOpen = false;
+        running = false;
+        analysis.join();
+
+        for (int attempt = 0; attempt < CAPTURE_REOPEN_ATTEMPTS && !deviceOpen; attempt++)
+        {
+            if (attempt > 0)
+                std::this_thread::sleep_for(std::chrono::milliseconds(CAPTURE_REOPEN_RETRY_MS));
+            deviceOpen = openCapture(&device, capture.get(), (ma_uint32)deviceChannels);
+        }
+        if (!deviceOpen)
+        {
+            std::cerr << "\nError: could not reopen capture device after " << CAPTURE_REOPEN_ATTEMPTS << " attempts" << std::endl;
+            deviceLost = true;
+            break;
+        }
+        applySampleRate(engines, (float)device.sampleRate);
+        for (auto &ring : rings)
+            ring->discard();
+        capture->marks.discard();
+        capture->samplesWritten = 0;
+        std::cout << "\nMixer rate changed: now " << device.sampleRate << " Hz" << std::endl;
+
+        running = true;
+        analysis = std::thread(dspThread, &engines, capture.get(), &writer, &status, &running);
+        ma_device_start(&device);
+    }
+
+    // Поток ввода заблокирован в getline: без устройства ждать Enter незачем,
+    // процесс завершится вместе с ним
+    if (deviceLost)
+        input.detach();
+    else
+        input.join();
+    if (deviceOpen)
+        ma_device_uninit(&device);
+    running = false;
+    if (analysis.joinable())
+        analysis.join();
+    writer.stop();
+#ifdef _WIN32
+    timeEndPeriod(1);
+#endif
+    printLatencyReport(stdout, false);
 
-    ma_device_uninit(&device);
-    CloseHandle(hSerial);
-    return 0;
+    serialPort.reset();
+    return deviceLost ? 1 : 0;
 }
\ No newline at end of file
@@ -0,0 +1,197 @@
+#include "multires_engine.h"
+#include <cstring>
+
+int multiResolutionFftSize(const BandData &band, float sampleRate, int maxFftSize, int minBins)
+{
+    const float maxBinHz = (band.freqMax - band.freqMin) / minBins;
+
+    int size = MIN_FFT_SIZE;
+    while (size < maxFftSize && sampleRate / size > maxBinHz)
+        size <<= 1;
+    return size;
+}
+
+void MultiResolutionEngine::Group::process(const float *samples, size_t count)
+{
+    if (decimation == 1)
+    {
+        engine->process(samples, count, *this);
+        return;
+    }
+
+    // Порции такие, чтобы выход дециматора гарантированно влез в буфер
+    const size_t maxInput = (size_t)(MULTIRES_DECIMATED_CHUNK - 1) * decimation;
+    while (count > 0)
+    {
+        const size_t n = count < maxInput ? count : maxInput;
+        const size_t produced = decimator.process(samples, n, decimated);
+        engine->process(decimated, produced, *this);
+        samples += n;
+        count -= n;
+    }
+}
+
+void MultiResolutionEngine::Group::onFrame(const uint8_t *groupLevels, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        const int b = bandIndex[i];
+        if (!owner->fresh[b] || groupLevels[i] > owner->held[b])
+            owner->held[b] = groupLevels[i];
+        owner->fresh[b] = true;
+    }
+}
+
+MultiResolutionEngine::MultiResolutionEngine(int maxFftSize) : maxFft(maxFftSize)
+{
+    memset(held, 0, sizeof(held));
+    memset(fresh, 0, sizeof(fresh));
+    memset(levels, 0, sizeof(levels));
+}
+
+bool MultiResolutionEngine::setBands(const std::vector<BandData> &newBands)
+{
+    if (newBands.size() > MAX_BANDS)
+        return false;
+    bands = newBands;
+    rebuildGroups();
+    return true;
+}
+
+void MultiResolutionEngine::setSampleRate(float newRate)
+{
+    rate = newRate;
+    rebuildGroups();
+}
+
+bool MultiResolutionEngine::setHopSize(int newHop)
+{
+    if (newHop < 1)
+        return false;
+    hop = newHop;
+    hopCounter = 0;
+    return true;
+}
+
+bool MultiResolutionEngine::setDecimation(int factor)
+{
+    PolyphaseDecimator probe;
+    if (factor != 1 && !probe.setFactor(factor))
+        return false;
+    decimation = factor;
+    rebuildGroups();
+    return true;
+}
+
+std::string MultiResolutionEngine::backendName() const
+{
+    std::string name;
+    for (const auto &group : groups)
+    {
+        if (!name.empty())
+            name += ", ";
+        name += std::to_string(group->engine->fftSize()) + " " + group->engine->backendName();
+        if (group->decimation > 1)
+            name += " (1/" + std::to_string(group->decimation) + " rate)";
+    }
+    return name;
+}
+
+bool MultiResolutionEngine::setDecimatedFftSize(int size)
+{
+    if (size != 0 && (size < MIN_FFT_SIZE || size > MAX_FFT_SIZE || (size & (size - 1)) != 0))
+        return false;
+    decimatedMinFft = size;
+    rebuildGroups();
+    return true;
+}
+
+void MultiResolutionEngine::setWindow(WindowType type)
+{
+    windowType = type;
+    for (auto &group : groups)
+        group->engine->setWindow(type);
+}
+
+// Раскладывает полосы по размерам FFT; вызывается только при смене настроек
+void MultiResolutionEngine::rebuildGroups()
+{
+    groups.clear();
+
+    for (size_t b = 0; b < bands.size(); b++)
+    {
+        // Басы, целиком попадающие в полосу пропускания дециматора, считаются
+        // на пониженной частоте: тот же размер FFT даёт окно в M раз длиннее
+        const bool decimate = decimation > 1 && bands[b].freqMax <= MULTIRES_DECIMATED_MAX_FREQ * rate / decimation;
+        const int groupDecimation = decimate ? decimation : 1;
+        const float groupRate = rate / groupDecimation;
+        int size = multiResolutionFftSize(bands[b], groupRate, maxFft,
+                                          decimate ? MULTIRES_DECIMATED_MIN_BINS : MULTIRES_MIN_BINS_PER_BAND);
+        if (decimate && size < decimatedMinFft)
+            size = decimatedMinFft < maxFft ? decimatedMinFft : maxFft;
+
+        Group *group = nullptr;
+        for (auto &existing : groups)
+        {
+            if (existing->engine->fftSize() == size && existing->decimation == groupDecimation)
+                group = existing.get();
+        }
+
+        if (!group)
+        {
+            groups.emplace_back(new Group());
+            group = groups.back().get();
+            group->owner = this;
+            group->decimation = groupDecimation;
+            if (decimate)
+                group->decimator.setFactor(groupDecimation);
+            group->engine = makeFftEngine(size);
+            group->engine->setSampleRate(groupRate);
+            group->engine->setHopSize(size / MULTIRES_OVERLAP);
+            group->engine->setWindow(windowType);
+        }
+        group->bandIndex.push_back((int)b);
+    }
+
+    for (auto &group : groups)
+    {
+        std::vector<BandData> groupBands;
+        for (int b : group->bandIndex)
+            groupBands.push_back(bands[b]);
+        group->engine->setBands(groupBands);
+    }
+
+    memset(held, 0, sizeof(held));
+    memset(fresh, 0, sizeof(fresh));
+    hopCounter = 0;
+}
+
+void MultiResolutionEngine::process(const float *samples, size_t count, FrameSink &sink)
+{
+    // Режем вход по границам выходных кадров, чтобы кадр видел ровно те
+    // результаты анализаторов, что пришлись на его интервал
+    while (count > 0)
+    {
+        size_t n = (size_t)(hop - hopCounter);
+        if (n > count)
+            n = count;
+
+        for (auto &group : groups)
+            group->process(samples, n);
+
+        samples += n;
+        count -= n;
+        hopCounter += (int)n;
+
+        if (hopCounter >= hop)
+        {
+            for (size_t b = 0; b < bands.size(); b++)
+            {
+                levels[b] = held[b];
+                fresh[b] = false;
+            }
+            sink.onFrame(levels, bands.size());
+            hopCounter = 0;
+        }
+    }
+}
@@ -0,0 +1,86 @@
+// Многоразрешающий анализ: каждая полоса считается самым коротким FFT,
+// которого хватает для её ширины. Бас — длинное окно, верха — короткое с частым шагом.
+#pragma once
+#include <memory>
+#include <vector>
+#include "audio_dsp.h"
+#include "band_engine.h"
+#include "polyphase_decimator.h"
+
+// Сколько бинов должно попасть в полосу, чтобы её пик был устойчивым
+#define MULTIRES_MIN_BINS_PER_BAND 8
+// Шаг каждого анализатора = N / 4 (перекрытие 75%)
+#define MULTIRES_OVERLAP 4
+// Басовые полосы после понижения частоты: окно той же длительности даёт в разы
+// больше бинов, поэтому требование к разрешению жёстче
+#define MULTIRES_DECIMATED_MIN_BINS 16
+// Разрешение сверх этого задаёт setDecimatedFftSize: например, 4096 точек на
+// 48000 / 8 — окно 0.68 с и ~1.5 Гц на бин
+// Полоса идёт через дециматор, только если целиком лежит в его полосе пропускания
+#define MULTIRES_DECIMATED_MAX_FREQ 0.35f // В долях новой частоты дискретизации
+// Сколько прореженных сэмплов группа обрабатывает за раз
+#define MULTIRES_DECIMATED_CHUNK 256
+// Выходной кадр каждые 128 сэмплов (~2.9 мс при 44.1 кГц), чтобы не терять скорость верхов
+#define MULTIRES_DEFAULT_HOP 128
+
+// Наименьший размер FFT из [MIN_FFT_SIZE, maxFftSize], при котором в полосу
+// попадает не меньше minBins бинов
+int multiResolutionFftSize(const BandData &band, float sampleRate, int maxFftSize, int minBins);
+
+struct MultiResolutionEngine : BandEngine
+{
+    // Анализаторы одного размера FFT и номера их полос в общем кадре.
+    // При decimation > 1 анализатор получает сэмплы через дециматор.
+    struct Group : FrameSink
+    {
+        MultiResolutionEngine *owner;
+        std::unique_ptr<BandEngine> engine;
+        std::vector<int> bandIndex;
+        int decimation = 1;
+        PolyphaseDecimator decimator;
+        float decimated[MULTIRES_DECIMATED_CHUNK];
+
+        void process(const float *samples, size_t count);
+        void onFrame(const uint8_t *groupLevels, size_t count) override;
+    };
+
+    std::vector<BandData> bands;
+    std::vector<std::unique_ptr<Group>> groups;
+    int maxFft;
+    int decimation = 1; // 1 — басовые полосы считаются на полной частоте
+    int decimatedMinFft = 0; // 0 — размер басового анализатора только по MULTIRES_DECIMATED_MIN_BINS
+    int hop = MULTIRES_DEFAULT_HOP;
+    int hopCounter = 0;
+    float rate = 44100.0f;
+    WindowType windowType = WindowType::Hann;
+
+    // Между выходными кадрами быстрые анализаторы копят максимум, медленные
+    // отдают своё последнее значение
+    uint8_t held[MAX_BANDS];
+    bool fresh[MAX_BANDS];
+    uint8_t levels[MAX_BANDS];
+
+    explicit MultiResolutionEngine(int maxFftSize);
+
+    bool setBands(const std::vector<BandData> &newBands) override;
+    void setSampleRate(float newRate) override;
+    // Частота выходных кадров; анализаторы работают со своим шагом
+    bool setHopSize(int newHop) override;
+    void setWindow(WindowType type) override;
+    // 4, 8 или 16 включает отдельный анализатор басов после дециматора, 1 — выключает
+    bool setDecimation(int factor);
+    // Наименьший размер FFT анализатора после дециматора (не больше maxFft);
+    // 0 — по числу бинов в полосе
+    bool setDecimatedFftSize(int size);
+
+    int fftSize() const override { return maxFft; }
+    int hopSize() const override { return hop; }
+    float sampleRate() const override { return rate; }
+    // Размер и реализация каждой группы, например "4096 split-radix (1/8 rate), 256 radix4"
+    std::string backendName() const override;
+
+    void process(const float *samples, size_t count, FrameSink &sink) override;
+
+private:
+    void rebuildGroups();
+};
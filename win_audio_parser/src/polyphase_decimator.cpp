@@ -0,0 +1,62 @@
+#include "polyphase_decimator.h"
+#include <cmath>
+
+bool PolyphaseDecimator::setFactor(int newFactor)
+{
+    if (newFactor != 4 && newFactor != 8 && newFactor != 16)
+        return false;
+
+    factor = newFactor;
+    const int length = factor * DECIMATOR_TAPS_PER_PHASE;
+
+    // Окно Блэкмана на sinc: срез на 80% новой частоты Найквиста, чтобы
+    // переходная полоса закончилась до точки наложения спектров
+    const double pi = 3.14159265358979323846;
+    const double cutoff = 0.8 * 0.5 / factor; // В долях входной частоты
+    const double center = (length - 1) / 2.0;
+
+    taps.assign(length, 0.0f);
+    double sum = 0.0;
+    for (int k = 0; k < length; k++)
+    {
+        const double t = k - center;
+        const double sinc = t == 0.0 ? 2.0 * cutoff : sin(2.0 * pi * cutoff * t) / (pi * t);
+        const double window = 0.42 - 0.5 * cos(2.0 * pi * k / (length - 1)) + 0.08 * cos(4.0 * pi * k / (length - 1));
+        taps[k] = (float)(sinc * window);
+        sum += taps[k];
+    }
+    // Единичное усиление на постоянном токе
+    for (float &tap : taps)
+        tap = (float)(tap / sum);
+
+    delay.assign(2 * length, 0.0f);
+    pos = 0;
+    phase = 0;
+    return true;
+}
+
+size_t PolyphaseDecimator::process(const float *in, size_t n, float *out)
+{
+    const int length = (int)taps.size();
+    const float *h = taps.data();
+    size_t produced = 0;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        delay[pos] = in[i];
+        delay[pos + length] = in[i];
+        pos = pos + 1 == length ? 0 : pos + 1;
+
+        if (++phase < factor)
+            continue;
+        phase = 0;
+
+        // delay[pos .. pos + length) — последние length сэмплов по порядку
+        const float *x = delay.data() + pos;
+        float acc = 0.0f;
+        for (int k = 0; k < length; k++)
+            acc += h[k] * x[k];
+        out[produced++] = acc;
+    }
+    return produced;
+}
@@ -0,0 +1,24 @@
+// Понижение частоты дискретизации в M раз: ФНЧ на КИХ-фильтре и прореживание.
+// Выход считается только для каждого M-го входного сэмпла (полифазная схема),
+// поэтому на входной сэмпл уходит taps / M умножений вместо taps.
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// Отводов на одну фазу: крутизна среза против стоимости
+#define DECIMATOR_TAPS_PER_PHASE 16
+
+struct PolyphaseDecimator
+{
+    int factor = 1;
+    int phase = 0;            // Входных сэмплов с момента предыдущего выхода
+    std::vector<float> taps;  // Импульсная характеристика от самого старого сэмпла к новому
+    std::vector<float> delay; // Линия задержки удвоенной длины: окно всегда непрерывно
+    int pos = 0;
+
+    // Допустимы 4, 8 и 16; фильтр пересчитывается и состояние сбрасывается
+    bool setFactor(int newFactor);
+
+    // Возвращает число выходных сэмплов (не больше n / factor + 1)
+    size_t process(const float *in, size_t n, float *out);
+};
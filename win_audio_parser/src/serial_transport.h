@@ -0,0 +1,40 @@
+// Транспорт до контроллера: последовательный порт Windows, tty Linux или
+// псевдотерминал для прогона всего конвейера без подключённой Arduino.
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#define SERIAL_DEFAULT_BAUD 115200
+// Дольше запись одного пакета не ждёт: пакет считается потерянным
+#define SERIAL_WRITE_TIMEOUT_MS 50
+
+#ifdef _WIN32
+#define SERIAL_DEFAULT_PORT "COM3"
+#else
+#define SERIAL_DEFAULT_PORT "/dev/ttyACM0"
+#endif
+
+struct SerialTransport
+{
+    virtual ~SerialTransport() = default;
+
+    // Пишет пакет целиком; false — ошибка или таймаут, пакет не дошёл
+    virtual bool write(const uint8_t *data, size_t size) = 0;
+    // Ждёт данные до timeoutMs и отдаёт то, что успело прийти; 0 — таймаут, -1 — ошибка
+    virtual int read(uint8_t *data, size_t size, int timeoutMs) = 0;
+    // Меняет скорость открытого порта; несогласованный остаток буферов теряется
+    virtual bool setBaud(int baud) = 0;
+    virtual const char *name() const = 0;
+};
+
+// Порт платформы в режиме 8N1 без управления потоком. Скорость — любая,
+// которую примет драйвер (на Linux через termios2, не только стандартные B*).
+// nullptr с сообщением в stderr, если порт не открылся.
+std::unique_ptr<SerialTransport> openSerialPort(const char *path, int baud);
+
+#ifndef _WIN32
+// Ведущая сторона псевдотерминала в сыром режиме. Путь ведомой стороны
+// (/dev/pts/N) печатается в stdout: её открывают вместо порта Arduino.
+std::unique_ptr<SerialTransport> openPtyTransport();
+#endif
@@ -0,0 +1,206 @@
+#include "serial_transport.h"
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+// termios2 (произвольная скорость через BOTHER) объявлен в заголовках ядра,
+// а они конфликтуют с <termios.h>: на Linux берём только их
+#if defined(__linux__)
+#include <asm/termbits.h>
+#include <sys/ioctl.h>
+typedef struct termios2 PortSettings;
+#else
+#include <termios.h>
+typedef struct termios PortSettings;
+#endif
+
+static bool getSettings(int fd, PortSettings *settings)
+{
+#if defined(__linux__)
+    return ioctl(fd, TCGETS2, settings) == 0;
+#else
+    return tcgetattr(fd, settings) == 0;
+#endif
+}
+
+static bool setSettings(int fd, const PortSettings *settings)
+{
+#if defined(__linux__)
+    return ioctl(fd, TCSETS2, settings) == 0;
+#else
+    return tcsetattr(fd, TCSANOW, settings) == 0;
+#endif
+}
+
+// То же, что cfmakeraw, плюс 8N1 без управления потоком
+static void makeRaw(PortSettings *settings)
+{
+    settings->c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL | IXON | IXOFF | IXANY);
+    settings->c_oflag &= ~OPOST;
+    settings->c_lflag &= ~(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
+    settings->c_cflag &= ~(CSIZE | PARENB | CSTOPB | CRTSCTS);
+    settings->c_cflag |= CS8 | CLOCAL | CREAD;
+    settings->c_cc[VMIN] = 1;
+    settings->c_cc[VTIME] = 0;
+}
+
+static bool setSpeed(PortSettings *settings, int baud)
+{
+#if defined(__linux__)
+    settings->c_cflag &= ~CBAUD;
+    settings->c_cflag |= BOTHER;
+    settings->c_ispeed = (speed_t)baud;
+    settings->c_ospeed = (speed_t)baud;
+    return true;
+#else
+    // macOS и BSD принимают скорость числом
+    return cfsetspeed(settings, (speed_t)baud) == 0;
+#endif
+}
+
+// Неблокирующий дескриптор: пишем, пока драйвер принимает, и ждём через poll,
+// когда буфер полон. Весь пакет должен уйти за SERIAL_WRITE_TIMEOUT_MS.
+struct PosixFdTransport : SerialTransport
+{
+    int fd;
+    int holdFd; // Ведомая сторона pty, которую держим сами; -1 для порта
+    std::string path;
+
+    PosixFdTransport(int portFd, int holdPortFd, const std::string &portPath) : fd(portFd), holdFd(holdPortFd), path(portPath) {}
+    ~PosixFdTransport() override
+    {
+        close(fd);
+        if (holdFd >= 0)
+            close(holdFd);
+    }
+
+    PosixFdTransport(const PosixFdTransport &) = delete;
+    PosixFdTransport &operator=(const PosixFdTransport &) = delete;
+
+    bool write(const uint8_t *data, size_t size) override
+    {
+        // Срок общий: частичные write не продлевают ожидание
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(SERIAL_WRITE_TIMEOUT_MS);
+        size_t done = 0;
+        while (done < size)
+        {
+            const ssize_t n = ::write(fd, data + done, size - done);
+            if (n > 0)
+            {
+                done += (size_t)n;
+                continue;
+            }
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+                return false;
+
+            // Пакет мог уйти наполовину: дожидаемся хвоста, иначе контроллер
+            // потеряет синхронизацию до следующего стартового байта
+            const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+            if (left <= 0)
+                return false;
+            pollfd waitFor = {fd, POLLOUT, 0};
+            const int ready = poll(&waitFor, 1, (int)left);
+            if (ready < 0 && errno == EINTR)
+                continue;
+            if (ready <= 0)
+                return false;
+        }
+        return true;
+    }
+
+    int read(uint8_t *data, size_t size, int timeoutMs) override
+    {
+        pollfd waitFor = {fd, POLLIN, 0};
+        const int ready = poll(&waitFor, 1, timeoutMs);
+        if (ready <= 0)
+            return ready < 0 && errno != EINTR ? -1 : 0;
+        const ssize_t n = ::read(fd, data, size);
+        if (n < 0)
+            return errno == EAGAIN || errno == EINTR ? 0 : -1;
+        return (int)n;
+    }
+
+    bool setBaud(int baud) override
+    {
+        // У pty скорость — только запись в termios, но её видит и другая сторона
+        PortSettings settings;
+        if (!getSettings(fd, &settings) || !setSpeed(&settings, baud) || !setSettings(fd, &settings))
+            return false;
+#if defined(__linux__)
+        return ioctl(fd, TCFLSH, TCIOFLUSH) == 0;
+#else
+        return tcflush(fd, TCIOFLUSH) == 0;
+#endif
+    }
+
+    const char *name() const override { return path.c_str(); }
+};
+
+std::unique_ptr<SerialTransport> openSerialPort(const char *path, int baud)
+{
+    const int fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0)
+    {
+        std::cerr << "Error: could not open " << path << ": " << strerror(errno) << std::endl;
+        return nullptr;
+    }
+
+    PortSettings settings;
+    if (!getSettings(fd, &settings))
+    {
+        std::cerr << "Error: " << path << " is not a serial port: " << strerror(errno) << std::endl;
+        close(fd);
+        return nullptr;
+    }
+    makeRaw(&settings);
+    if (!setSpeed(&settings, baud) || !setSettings(fd, &settings))
+    {
+        std::cerr << "Error: could not configure " << path << " at " << baud << " baud: " << strerror(errno) << std::endl;
+        close(fd);
+        return nullptr;
+    }
+    return std::unique_ptr<SerialTransport>(new PosixFdTransport(fd, -1, path));
+}
+
+std::unique_ptr<SerialTransport> openPtyTransport()
+{
+    const int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0)
+    {
+        std::cerr << "Error: could not create pseudo-terminal: " << strerror(errno) << std::endl;
+        if (master >= 0)
+            close(master);
+        return nullptr;
+    }
+    const std::string slavePath = ptsname(master);
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+    fcntl(master, F_SETFD, FD_CLOEXEC);
+
+    // Ведомую сторону держим открытой сами: иначе запись в ведущую падает
+    // с EIO, пока тест ещё не подключился или переподключается. Сырой режим
+    // задаётся на ведомой стороне — без него tty съест 0x0D и эхо.
+    const int hold = open(slavePath.c_str(), O_RDWR | O_NOCTTY | O_CLOEXEC);
+    PortSettings settings;
+    if (hold < 0 || !getSettings(hold, &settings))
+    {
+        std::cerr << "Error: could not open " << slavePath << ": " << strerror(errno) << std::endl;
+        if (hold >= 0)
+            close(hold);
+        close(master);
+        return nullptr;
+    }
+    makeRaw(&settings);
+    setSpeed(&settings, SERIAL_DEFAULT_BAUD);
+    setSettings(hold, &settings);
+
+    std::cout << "Pseudo-terminal ready: " << slavePath << std::endl;
+    return std::unique_ptr<SerialTransport>(new PosixFdTransport(master, hold, slavePath));
+}
@@ -0,0 +1,85 @@
+#include "serial_transport.h"
+#include <iostream>
+#include <string>
+#include <windows.h>
+
+struct Win32SerialPort : SerialTransport
+{
+    HANDLE handle;
+    std::string path;
+
+    Win32SerialPort(HANDLE portHandle, const std::string &portPath) : handle(portHandle), path(portPath) {}
+    ~Win32SerialPort() override { CloseHandle(handle); }
+
+    Win32SerialPort(const Win32SerialPort &) = delete;
+    Win32SerialPort &operator=(const Win32SerialPort &) = delete;
+
+    bool write(const uint8_t *data, size_t size) override
+    {
+        DWORD written = 0;
+        return WriteFile(handle, data, (DWORD)size, &written, NULL) && written == size;
+    }
+
+    int read(uint8_t *data, size_t size, int timeoutMs) override
+    {
+        // Вернуться, как только пришёл хоть один байт, но не позже timeoutMs
+        COMMTIMEOUTS timeouts = {0};
+        timeouts.ReadIntervalTimeout = MAXDWORD;
+        timeouts.ReadTotalTimeoutMultiplier = MAXDWORD;
+        timeouts.ReadTotalTimeoutConstant = (DWORD)timeoutMs;
+        timeouts.WriteTotalTimeoutConstant = SERIAL_WRITE_TIMEOUT_MS;
+        DWORD received = 0;
+        if (!SetCommTimeouts(handle, &timeouts) || !ReadFile(handle, data, (DWORD)size, &received, NULL))
+            return -1;
+        return (int)received;
+    }
+
+    bool setBaud(int baud) override
+    {
+        DCB dcbSerialParams = {0};
+        dcbSerialParams.DCBlength = sizeof(dcbSerialParams);
+        if (!GetCommState(handle, &dcbSerialParams))
+            return false;
+        dcbSerialParams.BaudRate = (DWORD)baud;
+        if (!SetCommState(handle, &dcbSerialParams))
+            return false;
+        return PurgeComm(handle, PURGE_RXCLEAR | PURGE_TXCLEAR) != 0;
+    }
+
+    const char *name() const override { return path.c_str(); }
+};
+
+std::unique_ptr<SerialTransport> openSerialPort(const char *path, int baud)
+{
+    // COM10 и выше открываются только через \\.\ — добавляем его и для коротких имён
+    std::string fullPath = path;
+    if (fullPath.compare(0, 4, "\\\\.\\") != 0)
+        fullPath = "\\\\.\\" + fullPath;
+
+    HANDLE handle = CreateFileA(fullPath.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        std::cerr << "Error: could not open " << path << " (error " << GetLastError() << ")" << std::endl;
+        return nullptr;
+    }
+
+    DCB dcbSerialParams = {0};
+    dcbSerialParams.DCBlength = sizeof(dcbSerialParams);
+    GetCommState(handle, &dcbSerialParams);
+    dcbSerialParams.BaudRate = (DWORD)baud;
+    dcbSerialParams.ByteSize = 8;
+    dcbSerialParams.StopBits = ONESTOPBIT;
+    dcbSerialParams.Parity = NOPARITY;
+
+    // Без таймаута WriteFile висит, пока драйвер не примет данные
+    COMMTIMEOUTS timeouts = {0};
+    timeouts.WriteTotalTimeoutConstant = SERIAL_WRITE_TIMEOUT_MS;
+
+    if (!SetCommState(handle, &dcbSerialParams) || !SetCommTimeouts(handle, &timeouts))
+    {
+        std::cerr << "Error: could not configure " << path << " at " << baud << " baud" << std::endl;
+        CloseHandle(handle);
+        return nullptr;
+    }
+    return std::unique_ptr<SerialTransport>(new Win32SerialPort(handle, path));
+}
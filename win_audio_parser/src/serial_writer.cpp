@@ -0,0 +1,74 @@
+#include "serial_writer.h"
+#include <chrono>
+#include "alloc_guard.h"
+
+void SerialWriter::setFormat(uint8_t format, uint8_t keyframeInterval)
+{
+    protocolEncoderInit(&encoder, format, keyframeInterval);
+}
+
+void SerialWriter::start()
+{
+    if (running)
+        return;
+    running = true;
+    thread = std::thread(&SerialWriter::run, this);
+}
+
+void SerialWriter::stop()
+{
+    running = false;
+    if (thread.joinable())
+        thread.join();
+}
+
+void SerialWriter::publish(const LevelFrame &newFrame)
+{
+    if (mailbox.publish(newFrame))
+        coalescedFrames.fetch_add(1, std::memory_order_relaxed);
+}
+
+void SerialWriter::run()
+{
+    allocGuardArm();
+
+    // Плата на повышенной скорости без кадров возвращается на базовую:
+    // в тишине (кадры без сигнала не отправляются) шлём PING
+    uint8_t ping[MAX_PACKET_SIZE];
+    const size_t pingSize = protocolEncodeControl(PROTOCOL_CMD_PING, NULL, 0, ping);
+    auto lastWrite = std::chrono::steady_clock::now();
+
+    while (running.load(std::memory_order_relaxed))
+    {
+        if (!mailbox.take(frame))
+        {
+            const auto now = std::chrono::steady_clock::now();
+            if (now - lastWrite >= std::chrono::milliseconds(PROTOCOL_KEEPALIVE_MS))
+            {
+                write(ping, pingSize);
+                lastWrite = now;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(SERIAL_WRITER_IDLE_MS));
+            continue;
+        }
+        lastWrite = std::chrono::steady_clock::now();
+
+        // Номер получают только отправляемые кадры: пропуск в номерах
+        // на приёмнике означает потерю на линии, а не вытеснение
+        const size_t size = encodeLevelsPacket(&encoder, frame.levels, frame.count, packet);
+        if (write(packet, size))
+        {
+            sentFrames.fetch_add(1, std::memory_order_relaxed);
+            sentBytes.fetch_add(size, std::memory_order_relaxed);
+        }
+        else
+        {
+            // Приёмник мог получить пол-кадра: дельта от него не сложится
+            protocolForceKeyframe(&encoder);
+            failedFrames.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        frame.stamps.at[(int)LatencyStage::WriteDone] = latencyNow();
+        latencyRecord(frame.stamps);
+    }
+}
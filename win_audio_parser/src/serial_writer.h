@@ -0,0 +1,69 @@
+// Передатчик в отдельном потоке: поток анализа отдаёт кадр и сразу идёт
+// дальше, даже если драйвер USB-serial завис. Передатчик всегда шлёт самый
+// свежий кадр, устаревшие выбрасываются, а не копятся в очереди.
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include "band_map.h"
+#include "latency_stats.h"
+#include "latest_mailbox.h"
+#include "level_packet.h"
+
+// Сколько ждёт передатчик, когда нового кадра нет
+#define SERIAL_WRITER_IDLE_MS 1
+
+struct LevelFrame
+{
+    size_t count;
+    uint8_t levels[MAX_BANDS];
+    FrameStamps stamps; // Отметки задержки; запись завершает передатчик
+};
+
+// Синхронная запись пакета целиком; false — ошибка или записано не всё
+typedef bool (*SerialWriteFn)(const uint8_t *data, size_t size);
+
+class SerialWriter
+{
+public:
+    explicit SerialWriter(SerialWriteFn writeFn) : write(writeFn)
+    {
+        protocolEncoderInit(&encoder, PROTOCOL_DELTA, DEFAULT_KEYFRAME_INTERVAL);
+    }
+    ~SerialWriter() { stop(); }
+
+    SerialWriter(const SerialWriter &) = delete;
+    SerialWriter &operator=(const SerialWriter &) = delete;
+
+    // Формат данных кадра (см. shared_protocol.h); задаётся до start
+    void setFormat(uint8_t format, uint8_t keyframeInterval);
+
+    void start();
+    void stop();
+
+    // Вызывается только потоком анализа; никогда не ждёт
+    void publish(const LevelFrame &frame);
+
+    uint64_t sent() const { return sentFrames.load(std::memory_order_relaxed); }
+    // Вытеснены более свежим кадром, не дойдя до порта
+    uint64_t coalesced() const { return coalescedFrames.load(std::memory_order_relaxed); }
+    uint64_t failed() const { return failedFrames.load(std::memory_order_relaxed); }
+    uint64_t bytes() const { return sentBytes.load(std::memory_order_relaxed); }
+
+private:
+    void run();
+
+    SerialWriteFn write;
+    LatestMailbox<LevelFrame> mailbox;
+    std::thread thread;
+    std::atomic<bool> running{false};
+    LevelFrame frame;                // Рабочие буферы передатчика
+    uint8_t packet[MAX_PACKET_SIZE];
+    ProtocolEncoder encoder;
+
+    std::atomic<uint64_t> sentFrames{0};
+    std::atomic<uint64_t> coalescedFrames{0};
+    std::atomic<uint64_t> failedFrames{0};
+    std::atomic<uint64_t> sentBytes{0};
+};
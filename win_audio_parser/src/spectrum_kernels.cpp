@@ -0,0 +1,138 @@
+#include "spectrum_kernels.h"
+
+#if defined(DSP_X86)
+#include <immintrin.h>
+#endif
+
+static float peakSqScalar(const float *spectrum, int first, int last, float peak)
+{
+    for (int bin = first; bin < last; bin++)
+    {
+        const float r = spectrum[2 * bin];
+        const float im = spectrum[2 * bin + 1];
+        const float sq = r * r + im * im;
+        if (sq > peak)
+            peak = sq;
+    }
+    return peak;
+}
+
+void bandPeaksScalar(const float *spectrum, const BandRange *ranges, size_t bandCount, float *peaksSq)
+{
+    for (size_t b = 0; b < bandCount; b++)
+        peaksSq[b] = peakSqScalar(spectrum, ranges[b].firstBin, ranges[b].lastBin, 0.0f);
+}
+
+#if defined(DSP_X86)
+
+// Порядок бинов внутри регистра после перестановок не важен: нужен только максимум
+
+void bandPeaksSse2(const float *spectrum, const BandRange *ranges, size_t bandCount, float *peaksSq)
+{
+    for (size_t b = 0; b < bandCount; b++)
+    {
+        int bin = ranges[b].firstBin;
+        const int last = ranges[b].lastBin;
+        __m128 peak = _mm_setzero_ps();
+
+        // 4 бина за итерацию: [r0 i0 r1 i1] [r2 i2 r3 i3] -> r^2 + i^2
+        for (; bin + 4 <= last; bin += 4)
+        {
+            __m128 a = _mm_loadu_ps(spectrum + 2 * bin);
+            __m128 c = _mm_loadu_ps(spectrum + 2 * bin + 4);
+            a = _mm_mul_ps(a, a);
+            c = _mm_mul_ps(c, c);
+            const __m128 re = _mm_shuffle_ps(a, c, _MM_SHUFFLE(2, 0, 2, 0));
+            const __m128 im = _mm_shuffle_ps(a, c, _MM_SHUFFLE(3, 1, 3, 1));
+            peak = _mm_max_ps(peak, _mm_add_ps(re, im));
+        }
+
+        peak = _mm_max_ps(peak, _mm_movehl_ps(peak, peak));
+        peak = _mm_max_ss(peak, _mm_shuffle_ps(peak, peak, _MM_SHUFFLE(1, 1, 1, 1)));
+        peaksSq[b] = peakSqScalar(spectrum, bin, last, _mm_cvtss_f32(peak));
+    }
+}
+
+DSP_TARGET_AVX2 void bandPeaksAvx2(const float *spectrum, const BandRange *ranges, size_t bandCount, float *peaksSq)
+{
+    for (size_t b = 0; b < bandCount; b++)
+    {
+        int bin = ranges[b].firstBin;
+        const int last = ranges[b].lastBin;
+        __m256 peak = _mm256_setzero_ps();
+
+        for (; bin + 8 <= last; bin += 8)
+        {
+            __m256 a = _mm256_loadu_ps(spectrum + 2 * bin);
+            __m256 c = _mm256_loadu_ps(spectrum + 2 * bin + 8);
+            a = _mm256_mul_ps(a, a);
+            c = _mm256_mul_ps(c, c);
+            const __m256 re = _mm256_shuffle_ps(a, c, _MM_SHUFFLE(2, 0, 2, 0));
+            const __m256 im = _mm256_shuffle_ps(a, c, _MM_SHUFFLE(3, 1, 3, 1));
+            peak = _mm256_max_ps(peak, _mm256_add_ps(re, im));
+        }
+
+        __m128 half = _mm_max_ps(_mm256_castps256_ps128(peak), _mm256_extractf128_ps(peak, 1));
+        half = _mm_max_ps(half, _mm_movehl_ps(half, half));
+        half = _mm_max_ss(half, _mm_shuffle_ps(half, half, _MM_SHUFFLE(1, 1, 1, 1)));
+        peaksSq[b] = peakSqScalar(spectrum, bin, last, _mm_cvtss_f32(half));
+    }
+}
+
+// Неполные формы AVX-512 в GCC 12 берут _mm512_undefined_*, и -Wmaybe-uninitialized
+// срабатывает на самих заголовках; формы с маской и явным источником его не трогают
+#define AVX512_ALL_LANES ((__mmask16)0xFFFF)
+
+DSP_TARGET_AVX512 void bandPeaksAvx512(const float *spectrum, const BandRange *ranges, size_t bandCount, float *peaksSq)
+{
+    for (size_t b = 0; b < bandCount; b++)
+    {
+        int bin = ranges[b].firstBin;
+        const int last = ranges[b].lastBin;
+        __m512 peak = _mm512_setzero_ps();
+
+        for (; bin + 16 <= last; bin += 16)
+        {
+            __m512 a = _mm512_loadu_ps(spectrum + 2 * bin);
+            __m512 c = _mm512_loadu_ps(spectrum + 2 * bin + 16);
+            a = _mm512_mul_ps(a, a);
+            c = _mm512_mul_ps(c, c);
+            const __m512 re = _mm512_shuffle_ps(a, c, _MM_SHUFFLE(2, 0, 2, 0));
+            const __m512 im = _mm512_shuffle_ps(a, c, _MM_SHUFFLE(3, 1, 3, 1));
+            peak = _mm512_mask_max_ps(peak, AVX512_ALL_LANES, peak, _mm512_add_ps(re, im));
+        }
+
+        // Свёртка вручную, как в AVX2, а не _mm512_reduce_max_ps; extractf32x8
+        // требует AVX512DQ, поэтому половины достаются как pd
+        const __m512d wide = _mm512_castps_pd(peak);
+        const __m256 lower = _mm256_castpd_ps(_mm512_mask_extractf64x4_pd(_mm256_setzero_pd(), 0xF, wide, 0));
+        const __m256 upper = _mm256_castpd_ps(_mm512_mask_extractf64x4_pd(_mm256_setzero_pd(), 0xF, wide, 1));
+        const __m256 quad = _mm256_max_ps(lower, upper);
+        __m128 half = _mm_max_ps(_mm256_castps256_ps128(quad), _mm256_extractf128_ps(quad, 1));
+        half = _mm_max_ps(half, _mm_movehl_ps(half, half));
+        half = _mm_max_ss(half, _mm_shuffle_ps(half, half, _MM_SHUFFLE(1, 1, 1, 1)));
+        peaksSq[b] = peakSqScalar(spectrum, bin, last, _mm_cvtss_f32(half));
+    }
+}
+
+#endif
+
+BandPeakKernel bandPeakKernel(SimdLevel level)
+{
+#if defined(DSP_X86)
+    switch (level)
+    {
+    case SimdLevel::Avx512:
+        return bandPeaksAvx512;
+    case SimdLevel::Avx2:
+        return bandPeaksAvx2;
+    case SimdLevel::Sse2:
+        return bandPeaksSse2;
+    default:
+        break;
+    }
+#else
+    (void)level;
+#endif
+    return bandPeaksScalar;
+}
@@ -0,0 +1,20 @@
+// Векторные ядра разбора спектра: квадрат амплитуды бинов и пик по каждой полосе
+#pragma once
+#include <cstddef>
+#include "band_map.h"
+#include "cpu_features.h"
+
+// spectrum — пары (re, im) подряд, как их отдаёт FftBackend::forward.
+// В peaksSq пишется максимум re*re + im*im по бинам каждой полосы:
+// корень и логарифм потом берутся один раз на полосу, а не на бин.
+typedef void (*BandPeakKernel)(const float *spectrum, const BandRange *ranges, size_t bandCount, float *peaksSq);
+
+void bandPeaksScalar(const float *spectrum, const BandRange *ranges, size_t bandCount, float *peaksSq);
+#if defined(DSP_X86)
+void bandPeaksSse2(const float *spectrum, const BandRange *ranges, size_t bandCount, float *peaksSq);
+void bandPeaksAvx2(const float *spectrum, const BandRange *ranges, size_t bandCount, float *peaksSq);
+void bandPeaksAvx512(const float *spectrum, const BandRange *ranges, size_t bandCount, float *peaksSq);
+#endif
+
+// Ядро для заданного уровня; уровень выше поддерживаемого сборкой сводится к скалярному
+BandPeakKernel bandPeakKernel(SimdLevel level);
@@ -0,0 +1,167 @@
+#include "split_radix_fft.h"
+
+#if defined(DSP_X86)
+#include <immintrin.h>
+#endif
+
+// a = W^k Z, b = W^3k Z', s = a + b, d = a - b:
+// X[k] = U[k] + s, X[k + len/2] = U[k] - s,
+// X[k + len/4] = U[k + len/4] - i d, X[k + 3len/4] = U[k + len/4] + i d
+static void splitRadixTail(float *re, float *im, int quarter, int k,
+                           const float *w1r, const float *w1i, const float *w3r, const float *w3i)
+{
+    float *zr = re + 2 * quarter, *zi = im + 2 * quarter;
+    float *yr = zr + quarter, *yi = zi + quarter;
+    for (; k < quarter; k++)
+    {
+        const float ar = zr[k] * w1r[k] - zi[k] * w1i[k];
+        const float ai = zr[k] * w1i[k] + zi[k] * w1r[k];
+        const float br = yr[k] * w3r[k] - yi[k] * w3i[k];
+        const float bi = yr[k] * w3i[k] + yi[k] * w3r[k];
+        const float sr = ar + br, si = ai + bi;
+        const float dr = ar - br, di = ai - bi;
+
+        const float u0r = re[k], u0i = im[k];
+        const float u1r = re[k + quarter], u1i = im[k + quarter];
+        re[k] = u0r + sr;
+        im[k] = u0i + si;
+        zr[k] = u0r - sr;
+        zi[k] = u0i - si;
+        re[k + quarter] = u1r + di;
+        im[k + quarter] = u1i - dr;
+        yr[k] = u1r - di;
+        yi[k] = u1i + dr;
+    }
+}
+
+void splitRadixScalar(float *re, float *im, int quarter,
+                      const float *w1r, const float *w1i, const float *w3r, const float *w3i)
+{
+    splitRadixTail(re, im, quarter, 0, w1r, w1i, w3r, w3i);
+}
+
+#if defined(DSP_X86)
+
+void splitRadixSse2(float *re, float *im, int quarter,
+                    const float *w1r, const float *w1i, const float *w3r, const float *w3i)
+{
+    float *zr = re + 2 * quarter, *zi = im + 2 * quarter;
+    float *yr = zr + quarter, *yi = zi + quarter;
+    int k = 0;
+    for (; k + 4 <= quarter; k += 4)
+    {
+        const __m128 vzr = _mm_loadu_ps(zr + k), vzi = _mm_loadu_ps(zi + k);
+        const __m128 vyr = _mm_loadu_ps(yr + k), vyi = _mm_loadu_ps(yi + k);
+        const __m128 c1 = _mm_loadu_ps(w1r + k), s1 = _mm_loadu_ps(w1i + k);
+        const __m128 c3 = _mm_loadu_ps(w3r + k), s3 = _mm_loadu_ps(w3i + k);
+
+        const __m128 ar = _mm_sub_ps(_mm_mul_ps(vzr, c1), _mm_mul_ps(vzi, s1));
+        const __m128 ai = _mm_add_ps(_mm_mul_ps(vzr, s1), _mm_mul_ps(vzi, c1));
+        const __m128 br = _mm_sub_ps(_mm_mul_ps(vyr, c3), _mm_mul_ps(vyi, s3));
+        const __m128 bi = _mm_add_ps(_mm_mul_ps(vyr, s3), _mm_mul_ps(vyi, c3));
+        const __m128 sr = _mm_add_ps(ar, br), si = _mm_add_ps(ai, bi);
+        const __m128 dr = _mm_sub_ps(ar, br), di = _mm_sub_ps(ai, bi);
+
+        const __m128 u0r = _mm_loadu_ps(re + k), u0i = _mm_loadu_ps(im + k);
+        const __m128 u1r = _mm_loadu_ps(re + k + quarter), u1i = _mm_loadu_ps(im + k + quarter);
+        _mm_storeu_ps(re + k, _mm_add_ps(u0r, sr));
+        _mm_storeu_ps(im + k, _mm_add_ps(u0i, si));
+        _mm_storeu_ps(zr + k, _mm_sub_ps(u0r, sr));
+        _mm_storeu_ps(zi + k, _mm_sub_ps(u0i, si));
+        _mm_storeu_ps(re + k + quarter, _mm_add_ps(u1r, di));
+        _mm_storeu_ps(im + k + quarter, _mm_sub_ps(u1i, dr));
+        _mm_storeu_ps(yr + k, _mm_sub_ps(u1r, di));
+        _mm_storeu_ps(yi + k, _mm_add_ps(u1i, dr));
+    }
+    splitRadixTail(re, im, quarter, k, w1r, w1i, w3r, w3i);
+}
+
+DSP_TARGET_AVX2 void splitRadixAvx2(float *re, float *im, int quarter,
+                                    const float *w1r, const float *w1i, const float *w3r, const float *w3i)
+{
+    float *zr = re + 2 * quarter, *zi = im + 2 * quarter;
+    float *yr = zr + quarter, *yi = zi + quarter;
+    int k = 0;
+    for (; k + 8 <= quarter; k += 8)
+    {
+        const __m256 vzr = _mm256_loadu_ps(zr + k), vzi = _mm256_loadu_ps(zi + k);
+        const __m256 vyr = _mm256_loadu_ps(yr + k), vyi = _mm256_loadu_ps(yi + k);
+        const __m256 c1 = _mm256_loadu_ps(w1r + k), s1 = _mm256_loadu_ps(w1i + k);
+        const __m256 c3 = _mm256_loadu_ps(w3r + k), s3 = _mm256_loadu_ps(w3i + k);
+
+        const __m256 ar = _mm256_fmsub_ps(vzr, c1, _mm256_mul_ps(vzi, s1));
+        const __m256 ai = _mm256_fmadd_ps(vzr, s1, _mm256_mul_ps(vzi, c1));
+        const __m256 br = _mm256_fmsub_ps(vyr, c3, _mm256_mul_ps(vyi, s3));
+        const __m256 bi = _mm256_fmadd_ps(vyr, s3, _mm256_mul_ps(vyi, c3));
+        const __m256 sr = _mm256_add_ps(ar, br), si = _mm256_add_ps(ai, bi);
+        const __m256 dr = _mm256_sub_ps(ar, br), di = _mm256_sub_ps(ai, bi);
+
+        const __m256 u0r = _mm256_loadu_ps(re + k), u0i = _mm256_loadu_ps(im + k);
+        const __m256 u1r = _mm256_loadu_ps(re + k + quarter), u1i = _mm256_loadu_ps(im + k + quarter);
+        _mm256_storeu_ps(re + k, _mm256_add_ps(u0r, sr));
+        _mm256_storeu_ps(im + k, _mm256_add_ps(u0i, si));
+        _mm256_storeu_ps(zr + k, _mm256_sub_ps(u0r, sr));
+        _mm256_storeu_ps(zi + k, _mm256_sub_ps(u0i, si));
+        _mm256_storeu_ps(re + k + quarter, _mm256_add_ps(u1r, di));
+        _mm256_storeu_ps(im + k + quarter, _mm256_sub_ps(u1i, dr));
+        _mm256_storeu_ps(yr + k, _mm256_sub_ps(u1r, di));
+        _mm256_storeu_ps(yi + k, _mm256_add_ps(u1i, dr));
+    }
+    splitRadixTail(re, im, quarter, k, w1r, w1i, w3r, w3i);
+}
+
+DSP_TARGET_AVX512 void splitRadixAvx512(float *re, float *im, int quarter,
+                                        const float *w1r, const float *w1i, const float *w3r, const float *w3i)
+{
+    float *zr = re + 2 * quarter, *zi = im + 2 * quarter;
+    float *yr = zr + quarter, *yi = zi + quarter;
+    int k = 0;
+    for (; k + 16 <= quarter; k += 16)
+    {
+        const __m512 vzr = _mm512_loadu_ps(zr + k), vzi = _mm512_loadu_ps(zi + k);
+        const __m512 vyr = _mm512_loadu_ps(yr + k), vyi = _mm512_loadu_ps(yi + k);
+        const __m512 c1 = _mm512_loadu_ps(w1r + k), s1 = _mm512_loadu_ps(w1i + k);
+        const __m512 c3 = _mm512_loadu_ps(w3r + k), s3 = _mm512_loadu_ps(w3i + k);
+
+        const __m512 ar = _mm512_fmsub_ps(vzr, c1, _mm512_mul_ps(vzi, s1));
+        const __m512 ai = _mm512_fmadd_ps(vzr, s1, _mm512_mul_ps(vzi, c1));
+        const __m512 br = _mm512_fmsub_ps(vyr, c3, _mm512_mul_ps(vyi, s3));
+        const __m512 bi = _mm512_fmadd_ps(vyr, s3, _mm512_mul_ps(vyi, c3));
+        const __m512 sr = _mm512_add_ps(ar, br), si = _mm512_add_ps(ai, bi);
+        const __m512 dr = _mm512_sub_ps(ar, br), di = _mm512_sub_ps(ai, bi);
+
+        const __m512 u0r = _mm512_loadu_ps(re + k), u0i = _mm512_loadu_ps(im + k);
+        const __m512 u1r = _mm512_loadu_ps(re + k + quarter), u1i = _mm512_loadu_ps(im + k + quarter);
+        _mm512_storeu_ps(re + k, _mm512_add_ps(u0r, sr));
+        _mm512_storeu_ps(im + k, _mm512_add_ps(u0i, si));
+        _mm512_storeu_ps(zr + k, _mm512_sub_ps(u0r, sr));
+        _mm512_storeu_ps(zi + k, _mm512_sub_ps(u0i, si));
+        _mm512_storeu_ps(re + k + quarter, _mm512_add_ps(u1r, di));
+        _mm512_storeu_ps(im + k + quarter, _mm512_sub_ps(u1i, dr));
+        _mm512_storeu_ps(yr + k, _mm512_sub_ps(u1r, di));
+        _mm512_storeu_ps(yi + k, _mm512_add_ps(u1i, dr));
+    }
+    splitRadixTail(re, im, quarter, k, w1r, w1i, w3r, w3i);
+}
+
+#endif
+
+SplitRadixKernel splitRadixKernel(SimdLevel level)
+{
+#if defined(DSP_X86)
+    switch (level)
+    {
+    case SimdLevel::Avx512:
+        return splitRadixAvx512;
+    case SimdLevel::Avx2:
+        return splitRadixAvx2;
+    case SimdLevel::Sse2:
+        return splitRadixSse2;
+    default:
+        break;
+    }
+#else
+    (void)level;
+#endif
+    return splitRadixScalar;
+}
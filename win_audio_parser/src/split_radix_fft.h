@@ -0,0 +1,26 @@
+// Ядра комплексного split-radix FFT: бабочка в форме буквы L, которая
+// сшивает FFT чётных отсчётов на len / 2 и два FFT на len / 4 в один на len.
+// Умножений на поворачивающие множители меньше, чем у radix-4, а цикл
+// по k идёт подряд по раздельным массивам re и im — его векторизуют явно.
+#pragma once
+#include "cpu_features.h"
+
+// re, im — len = 4 * quarter точек, по порядку: U[0..len/2) — FFT чётных,
+// Z[len/2..3len/4) — FFT отсчётов 4j+1, Z'[3len/4..len) — FFT отсчётов 4j+3.
+// w1 = W_len^k, w3 = W_len^3k для k < quarter. Результат пишется на место.
+typedef void (*SplitRadixKernel)(float *re, float *im, int quarter,
+                                 const float *w1r, const float *w1i, const float *w3r, const float *w3i);
+
+void splitRadixScalar(float *re, float *im, int quarter,
+                      const float *w1r, const float *w1i, const float *w3r, const float *w3i);
+#if defined(DSP_X86)
+void splitRadixSse2(float *re, float *im, int quarter,
+                    const float *w1r, const float *w1i, const float *w3r, const float *w3i);
+void splitRadixAvx2(float *re, float *im, int quarter,
+                    const float *w1r, const float *w1i, const float *w3r, const float *w3i);
+void splitRadixAvx512(float *re, float *im, int quarter,
+                      const float *w1r, const float *w1i, const float *w3r, const float *w3i);
+#endif
+
+// Ядро для заданного уровня; уровень выше поддерживаемого сборкой сводится к скалярному
+SplitRadixKernel splitRadixKernel(SimdLevel level);
@@ -0,0 +1,93 @@
+// Кольцевой буфер без блокировок: один писатель (аудиопоток) и один читатель (поток DSP)
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+template <typename T>
+class SpscRing
+{
+public:
+    // Ёмкость округляется вверх до степени двойки, чтобы индекс брался маской
+    explicit SpscRing(size_t minCapacity)
+    {
+        capacity = 1;
+        while (capacity < minCapacity)
+            capacity <<= 1;
+        mask = capacity - 1;
+        buffer.reset(new T[capacity]());
+    }
+
+    SpscRing(const SpscRing &) = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+
+    // Вызывается только писателем. Никогда не ждёт: то, что не влезло, отбрасывается
+    // и учитывается в счётчиках переполнения. stride > 1 позволяет брать один канал
+    // из интерлейсного буфера без промежуточной копии.
+    size_t write(const T *src, size_t count, size_t stride = 1)
+    {
+        const size_t head = writeIndex.load(std::memory_order_relaxed);
+        const size_t tail = readIndex.load(std::memory_order_acquire);
+        const size_t freeSpace = capacity - (head - tail);
+
+        size_t toWrite = count;
+        if (toWrite > freeSpace)
+        {
+            toWrite = freeSpace;
+            overrunEvents.fetch_add(1, std::memory_order_relaxed);
+            droppedItems.fetch_add(count - toWrite, std::memory_order_relaxed);
+        }
+
+        for (size_t i = 0; i < toWrite; i++)
+            buffer[(head + i) & mask] = src[i * stride];
+
+        writeIndex.store(head + toWrite, std::memory_order_release);
+        return toWrite;
+    }
+
+    // Вызывается только читателем
+    size_t read(T *dst, size_t maxCount)
+    {
+        const size_t tail = readIndex.load(std::memory_order_relaxed);
+        const size_t head = writeIndex.load(std::memory_order_acquire);
+
+        size_t toRead = head - tail;
+        if (toRead > maxCount)
+            toRead = maxCount;
+
+        for (size_t i = 0; i < toRead; i++)
+            dst[i] = buffer[(tail + i) & mask];
+
+        readIndex.store(tail + toRead, std::memory_order_release);
+        return toRead;
+    }
+
+    // Вызывается только читателем: выбрасывает всё накопленное
+    void discard()
+    {
+        readIndex.store(writeIndex.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    size_t available() const
+    {
+        return writeIndex.load(std::memory_order_acquire) - readIndex.load(std::memory_order_acquire);
+    }
+
+    size_t size() const { return capacity; }
+
+    // Сколько раз писателю не хватило места и сколько элементов при этом потеряно
+    uint64_t overruns() const { return overrunEvents.load(std::memory_order_relaxed); }
+    uint64_t dropped() const { return droppedItems.load(std::memory_order_relaxed); }
+
+private:
+    std::unique_ptr<T[]> buffer;
+    size_t capacity;
+    size_t mask;
+
+    // Индексы на разных кэш-линиях, чтобы писатель и читатель не мешали друг другу
+    alignas(64) std::atomic<size_t> writeIndex{0};
+    alignas(64) std::atomic<size_t> readIndex{0};
+    alignas(64) std::atomic<uint64_t> overrunEvents{0};
+    std::atomic<uint64_t> droppedItems{0};
+};
@@ -0,0 +1,167 @@
+// Оконные функции, посчитанные один раз на этапе компиляции для каждого размера FFT
+#pragma once
+#include <array>
+#include <cstring>
+
+enum class WindowType
+{
+    Hann,
+    BlackmanHarris,
+    FlatTop,
+    Kaiser,
+};
+
+// Параметр окна Кайзера: боковые лепестки около -90 дБ, как у Блэкмана-Харриса
+#define KAISER_BETA 8.6
+
+namespace window_detail
+{
+    constexpr double PI = 3.14159265358979323846;
+
+    // std::cos не constexpr, поэтому свой ряд Тейлора после приведения к [-pi, pi]
+    constexpr double cosine(double x)
+    {
+        const double turns = x / (2.0 * PI);
+        const long long whole = (long long)(turns >= 0.0 ? turns + 0.5 : turns - 0.5);
+        x -= (double)whole * 2.0 * PI;
+
+        const double x2 = x * x;
+        double term = 1.0;
+        double sum = 1.0;
+        for (int k = 1; k <= 12; k++)
+        {
+            term *= -x2 / ((2.0 * k - 1.0) * (2.0 * k));
+            sum += term;
+        }
+        return sum;
+    }
+
+    constexpr double squareRoot(double x)
+    {
+        if (x <= 0.0)
+            return 0.0;
+        double r = x > 1.0 ? x : 1.0;
+        for (int i = 0; i < 64; i++)
+        {
+            const double next = 0.5 * (r + x / r);
+            if (next == r)
+                break;
+            r = next;
+        }
+        return r;
+    }
+
+    // Модифицированная функция Бесселя нулевого порядка (ряд сходится быстро при x < 20)
+    constexpr double besselI0(double x)
+    {
+        const double halfX2 = (x * 0.5) * (x * 0.5);
+        double term = 1.0;
+        double sum = 1.0;
+        for (int k = 1; k < 40 && term > 1e-12 * sum; k++)
+        {
+            term *= halfX2 / ((double)k * (double)k);
+            sum += term;
+        }
+        return sum;
+    }
+
+    // Обобщённое косинусное окно: a0 - a1*cos + a2*cos2 - a3*cos3 + a4*cos4
+    constexpr double cosineSum(const double *a, int terms, int j, int n)
+    {
+        const double phase = 2.0 * PI * j / (n - 1);
+        double w = 0.0;
+        double sign = 1.0;
+        for (int k = 0; k < terms; k++)
+        {
+            w += sign * a[k] * cosine(k * phase);
+            sign = -sign;
+        }
+        return w;
+    }
+
+    constexpr double value(WindowType type, int j, int n)
+    {
+        constexpr double hann[] = {0.5, 0.5};
+        constexpr double blackmanHarris[] = {0.35875, 0.48829, 0.14128, 0.01168};
+        constexpr double flatTop[] = {0.21557895, 0.41663158, 0.277263158, 0.083578947, 0.006947368};
+
+        switch (type)
+        {
+        case WindowType::Hann:
+            return cosineSum(hann, 2, j, n);
+        case WindowType::BlackmanHarris:
+            return cosineSum(blackmanHarris, 4, j, n);
+        case WindowType::FlatTop:
+            return cosineSum(flatTop, 5, j, n);
+        case WindowType::Kaiser:
+        {
+            const double t = 2.0 * j / (n - 1) - 1.0;
+            return besselI0(KAISER_BETA * squareRoot(1.0 - t * t)) / besselI0(KAISER_BETA);
+        }
+        }
+        return 1.0;
+    }
+}
+
+template <int N>
+struct WindowTable
+{
+    std::array<float, N> coeffs{};
+    // Поправка амплитуды к уровню окна Ханна, чтобы смена окна не меняла яркость
+    float gainToHann = 1.0f;
+};
+
+template <int N>
+constexpr WindowTable<N> makeWindowTable(WindowType type)
+{
+    WindowTable<N> table{};
+    double sum = 0.0;
+    for (int j = 0; j < N; j++)
+    {
+        const double w = window_detail::value(type, j, N);
+        table.coeffs[j] = (float)w;
+        sum += w;
+    }
+    // Когерентное усиление окна Ханна = 0.5
+    table.gainToHann = (float)(0.5 * N / sum);
+    return table;
+}
+
+template <int N, WindowType W>
+struct WindowStorage
+{
+    static constexpr WindowTable<N> table = makeWindowTable<N>(W);
+};
+
+// Выбор таблицы во время работы; сами таблицы лежат в .rodata готовыми
+template <int N>
+const WindowTable<N> &windowTable(WindowType type)
+{
+    switch (type)
+    {
+    case WindowType::BlackmanHarris:
+        return WindowStorage<N, WindowType::BlackmanHarris>::table;
+    case WindowType::FlatTop:
+        return WindowStorage<N, WindowType::FlatTop>::table;
+    case WindowType::Kaiser:
+        return WindowStorage<N, WindowType::Kaiser>::table;
+    case WindowType::Hann:
+    default:
+        return WindowStorage<N, WindowType::Hann>::table;
+    }
+}
+
+inline bool parseWindowType(const char *name, WindowType *out)
+{
+    if (strcmp(name, "hann") == 0)
+        *out = WindowType::Hann;
+    else if (strcmp(name, "blackman-harris") == 0)
+        *out = WindowType::BlackmanHarris;
+    else if (strcmp(name, "flattop") == 0)
+        *out = WindowType::FlatTop;
+    else if (strcmp(name, "kaiser") == 0)
+        *out = WindowType::Kaiser;
+    else
+        return false;
+    return true;
+}
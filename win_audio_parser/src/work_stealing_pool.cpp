@@ -0,0 +1,112 @@
+#include "work_stealing_pool.h"
+
+// Номер очереди потока пула; -1 у посторонних потоков
+static thread_local const WorkStealingPool *currentPool = nullptr;
+static thread_local int currentIndex = -1;
+
+WorkStealingPool::WorkStealingPool(int threadCount)
+{
+    if (threadCount <= 0)
+        threadCount = (int)std::thread::hardware_concurrency();
+    if (threadCount <= 0)
+        threadCount = 1;
+
+    for (int i = 0; i < threadCount; i++)
+        queues.emplace_back(new Queue());
+    for (int i = 0; i < threadCount; i++)
+        workers.emplace_back(&WorkStealingPool::workerLoop, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> guard(idleLock);
+        stopping = true;
+    }
+    wakeWorkers.notify_all();
+    for (auto &worker : workers)
+        worker.join();
+}
+
+void WorkStealingPool::submit(Task task)
+{
+    // Изнутри пула — в свою очередь (кэш ещё тёплый), снаружи — по кругу
+    int index = currentPool == this ? currentIndex : (int)(nextQueue++ % queues.size());
+
+    pending++;
+    {
+        std::lock_guard<std::mutex> guard(queues[index]->lock);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    {
+        // Счётчик меняется под idleLock, иначе поток может уснуть, не увидев задачу
+        std::lock_guard<std::mutex> guard(idleLock);
+        queued++;
+    }
+    wakeWorkers.notify_one();
+}
+
+void WorkStealingPool::wait()
+{
+    std::unique_lock<std::mutex> guard(idleLock);
+    allDone.wait(guard, [this]
+                 { return pending.load() == 0; });
+}
+
+// Своя очередь разбирается с конца (последнее поставленное ещё в кэше),
+// чужие — с начала, где лежат самые старые и обычно самые крупные задачи
+bool WorkStealingPool::takeTask(int index, Task &task)
+{
+    {
+        Queue &own = *queues[index];
+        std::lock_guard<std::mutex> guard(own.lock);
+        if (!own.tasks.empty())
+        {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    const int count = (int)queues.size();
+    for (int i = 1; i < count; i++)
+    {
+        Queue &victim = *queues[(index + i) % count];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.tasks.empty())
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::workerLoop(int index)
+{
+    currentPool = this;
+    currentIndex = index;
+
+    for (;;)
+    {
+        Task task;
+        if (takeTask(index, task))
+        {
+            queued--;
+            task();
+            if (--pending == 0)
+            {
+                std::lock_guard<std::mutex> guard(idleLock);
+                allDone.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> guard(idleLock);
+        wakeWorkers.wait(guard, [this]
+                         { return stopping || queued.load() > 0; });
+        if (stopping && queued.load() == 0)
+            return;
+    }
+}
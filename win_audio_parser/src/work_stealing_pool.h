@@ -0,0 +1,52 @@
+// Пул потоков с кражей задач: у каждого потока своя очередь, свободный поток
+// забирает задачи из чужих. Задача может ставить новые задачи — они попадают
+// в очередь текущего потока, и соседи разбирают их, когда освободятся.
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkStealingPool
+{
+public:
+    typedef std::function<void()> Task;
+
+    // threadCount <= 0 — по числу логических ядер
+    explicit WorkStealingPool(int threadCount);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    void submit(Task task);
+    // Ждёт, пока не выполнятся все задачи, включая поставленные изнутри задач
+    void wait();
+
+    int threadCount() const { return (int)workers.size(); }
+
+private:
+    struct Queue
+    {
+        std::mutex lock;
+        std::deque<Task> tasks;
+    };
+
+    void workerLoop(int index);
+    bool takeTask(int index, Task &task);
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<unsigned> nextQueue{0};
+
+    std::mutex idleLock;
+    std::condition_variable wakeWorkers;
+    std::condition_variable allDone;
+    std::atomic<size_t> queued{0};  // Задачи, лежащие в очередях
+    std::atomic<size_t> pending{0}; // Поставленные и ещё не завершённые
+    bool stopping = false;
+};
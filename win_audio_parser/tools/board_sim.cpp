@@ -0,0 +1,167 @@
+// Заменитель Arduino на псевдотерминале: отвечает на согласование скорости
+// и SET_CURVE и принимает кадры яркостей тем же кодом из shared_protocol.h,
+// что и прошивка.
+// board_sim [--max-reliable baud] [--error-rate N] [--clock hz]
+// Печатает путь /dev/pts/N — его передают визуализатору как --port.
+//
+// USART эмулируется по скорости, которую ПК выставил на своей стороне pty:
+// пока она не совпадает со скоростью «платы», байты в обе стороны портятся,
+// а выше --max-reliable портится в среднем каждый N-й байт.
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <asm/termbits.h>
+#include <sys/ioctl.h>
+#include "shared_protocol.h"
+
+#define SIM_DEFAULT_CLOCK 16000000
+#define SIM_DEFAULT_ERROR_RATE 50
+#define SIM_REPORT_MS 1000
+// Как у прошивки: шесть выводов ШИМ, после включения кривая CIE
+#define SIM_CHANNELS 6
+#define SIM_DEFAULT_CURVE PROTOCOL_CURVE_CIE
+
+static uint32_t nowMs()
+{
+    using namespace std::chrono;
+    return (uint32_t)duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Скорость, на которую ПК настроил свою сторону; ведущая сторона видит termios ведомой
+static uint32_t hostBaud(int master)
+{
+    struct termios2 settings;
+    if (ioctl(master, TCGETS2, &settings) != 0)
+        return 0;
+    return settings.c_ospeed;
+}
+
+// Байт, прошедший через линию со скоростями host и board
+static uint8_t wire(uint8_t byte, uint32_t host, uint32_t board, uint32_t maxReliable, int errorRate)
+{
+    if (host != board)
+        return (uint8_t)(byte ^ 0xA5);
+    if (board > maxReliable && rand() % errorRate == 0)
+        return (uint8_t)(byte ^ (1 << (rand() % 8)));
+    return byte;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t clock = SIM_DEFAULT_CLOCK;
+    uint32_t maxReliable = 0xFFFFFFFF;
+    int errorRate = SIM_DEFAULT_ERROR_RATE;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--max-reliable") == 0 && i + 1 < argc)
+            maxReliable = (uint32_t)atol(argv[++i]);
+        else if (strcmp(argv[i], "--error-rate") == 0 && i + 1 < argc)
+            errorRate = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--clock") == 0 && i + 1 < argc)
+            clock = (uint32_t)atol(argv[++i]);
+    }
+    if (errorRate < 1)
+        errorRate = 1;
+
+    const int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0)
+    {
+        fprintf(stderr, "Error: could not create pseudo-terminal: %s\n", strerror(errno));
+        return 1;
+    }
+    // Пока ПК не подключился, чтение ведущей стороны даёт EIO; держим ведомую
+    // открытой сами и сразу переводим её в сырой режим на базовой скорости
+    const char *slavePath = ptsname(master);
+    const int hold = open(slavePath, O_RDWR | O_NOCTTY);
+    struct termios2 settings;
+    if (hold < 0 || ioctl(hold, TCGETS2, &settings) != 0)
+    {
+        fprintf(stderr, "Error: could not open %s: %s\n", slavePath, strerror(errno));
+        return 1;
+    }
+    settings.c_iflag = 0;
+    settings.c_oflag = 0;
+    settings.c_lflag = 0;
+    settings.c_cflag = CS8 | CLOCAL | CREAD | BOTHER;
+    settings.c_ispeed = settings.c_ospeed = PROTOCOL_BASE_BAUD;
+    settings.c_cc[VMIN] = 1;
+    settings.c_cc[VTIME] = 0;
+    ioctl(hold, TCSETS2, &settings);
+
+    printf("Board stand-in ready: %s (USART clock %u Hz)\n", slavePath, clock);
+    fflush(stdout);
+
+    ProtocolDecoder decoder;
+    ProtocolLevels received;
+    LinkState link;
+    protocolDecoderInit(&decoder);
+    protocolLevelsInit(&received);
+    linkInit(&link, clock, nowMs());
+
+    uint8_t curves[SIM_CHANNELS];
+    memset(curves, SIM_DEFAULT_CURVE, sizeof(curves));
+
+    uint8_t reply[PROTOCOL_MAX_FRAME];
+    uint8_t buffer[256];
+    unsigned levelFrames = 0;
+    uint32_t nextReport = nowMs() + SIM_REPORT_MS;
+    for (;;)
+    {
+        pollfd waitFor = {master, POLLIN, 0};
+        if (poll(&waitFor, 1, 10) > 0)
+        {
+            const ssize_t n = read(master, buffer, sizeof(buffer));
+            for (ssize_t i = 0; i < n; i++)
+            {
+                const uint8_t byte = wire(buffer[i], hostBaud(master), link.baud, maxReliable, errorRate);
+                if (!protocolDecode(&decoder, byte))
+                    continue;
+
+                uint32_t switchTo = 0;
+                const uint32_t replyBaud = link.baud;
+                link.rxBad = decoder.framesBad;
+                uint8_t replySize = linkOnFrame(&link, &decoder, nowMs(), reply, &switchTo);
+                if (protocolControlCommand(&decoder) == PROTOCOL_CMD_SET_CURVE)
+                    replySize = protocolApplyCurves(&decoder, curves, SIM_CHANNELS, reply);
+                for (uint8_t b = 0; b < replySize; b++)
+                    reply[b] = wire(reply[b], hostBaud(master), replyBaud, maxReliable, errorRate);
+                if (replySize > 0 && write(master, reply, replySize) != replySize)
+                    fprintf(stderr, "Error: reply lost\n");
+                if (switchTo != 0)
+                {
+                    protocolDecoderReset(&decoder);
+                    printf("switching to %u baud\n", switchTo);
+                }
+                if (protocolApplyFrame(&decoder, &received))
+                    levelFrames++;
+            }
+        }
+
+        const uint32_t fallback = linkPoll(&link, nowMs());
+        if (fallback != 0)
+        {
+            protocolDecoderReset(&decoder);
+            printf("fallback to %u baud\n", fallback);
+        }
+
+        if ((int32_t)(nowMs() - nextReport) >= 0)
+        {
+            nextReport += SIM_REPORT_MS;
+            printf("%u baud%s | frames ok %u, bad %u, levels %u, deltas dropped %u |", link.baud,
+                   link.verifying ? " (verifying)" : "", decoder.framesOk, decoder.framesBad, levelFrames,
+                   received.deltasDropped);
+            for (uint8_t c = 0; c < received.count; c++)
+                printf(" %3d", received.levels[c]);
+            printf(" | curves");
+            for (uint8_t c = 0; c < SIM_CHANNELS; c++)
+                printf(" %u", curves[c]);
+            printf("\n");
+            fflush(stdout);
+        }
+    }
+}